@@ -2,31 +2,51 @@
 
 #include "MazeSolver_conf.h"
 #include "Agent.h"
+#include "Profiler.h"
 
 
-void Agent::reset()
+template<int N>
+void AgentT<N>::reset()
 {
-	state = Agent::IDLE;
+	state = AgentT::IDLE;
 	path.clear();
 	toDistinationPath.clear();
 	distIndexList.clear();
+#if AGENT_USE_SEARCH_TOUR
+	tour.clear();
+	tourLegStep = MazeT<N>::STEP_MAX;
+#endif
 
 	dist.x = 0;
 	dist.y = 0;
 	nextDir = 0;
 }
 
-Direction Agent::calcNextDirection(const IndexVec &cur, const IndexVec &_dist)
+template<int N>
+Direction AgentT<N>::calcNextDirection(const IndexVec &cur, const IndexVec &_dist)
 {
 	maze->updateStepMap(_dist);
-	const uint8_t curStep = maze->getStepMap(cur);
-	if (curStep == 255) return Direction(0);
+	return nextDirectionOnStepMap(cur);
+}
+
+template<int N>
+Direction AgentT<N>::calcNextDirection(const IndexVec &cur, const IndexList &distList)
+{
+	maze->updateStepMap(distList);
+	return nextDirectionOnStepMap(cur);
+}
+
+template<int N>
+Direction AgentT<N>::nextDirectionOnStepMap(const IndexVec &cur) const
+{
+	const typename MazeT<N>::Step curStep = maze->getStepMap(cur);
+	if (curStep == MazeT<N>::STEP_MAX) return Direction(0);
 
 	Direction result(0);
 	int nFoundWall = 10;
 	const Direction cur_wall = maze->getWall(cur);
 	for (int i=0;i<4;i++) {
-		if (cur.canSum(IndexVec::vecDir[i])) {
+		if (cur.canSum(IndexVec::vecDir[i], N)) {
 			IndexVec neighbor(cur + IndexVec::vecDir[i]);
 			if (!cur_wall[i] && maze->getStepMap(neighbor) < curStep ) {
 				//北優先
@@ -42,7 +62,7 @@ Direction Agent::calcNextDirection(const IndexVec &cur, const IndexVec &_dist)
 	if (result) return result;
 
 	for (int i=0;i<4;i++) {
-		if (cur.canSum(IndexVec::vecDir[i])) {
+		if (cur.canSum(IndexVec::vecDir[i], N)) {
 			IndexVec neighbor(cur + IndexVec::vecDir[i]);
 			if (!cur_wall[i] && maze->getStepMap(neighbor) == curStep ) {
 				//北優先
@@ -59,20 +79,140 @@ Direction Agent::calcNextDirection(const IndexVec &cur, const IndexVec &_dist)
 	return result;
 }
 
+template<int N>
+void AgentT<N>::calcNeedToSearchIndex()
+{
+#if AGENT_SEARCH_TARGET == SEARCH_BY_TIME
+	//未探索の壁ごとに、その壁を通る経路の走行時間の最小値を見積もり、
+	//今わかっている壁だけで走れる経路よりSEARCH_TIME_THRESHOLD以上速くなりうる壁のうち、
+	//楽観的な最短の走行時間からSEARCH_TIME_MARGIN以内の経路が通る壁を探索する
+	path.calcNeedToSearchWallIndexByTime(IndexVec(0,0), goalList, SEARCH_TIME_THRESHOLD, SEARCH_TIME_MARGIN, searchDiagonalPath, *searchProfile);
+#else
+	path.calcKShortestDistancePath(IndexVec(0,0), goalList, SEARCH_DEPTH1, false);
+	path.calcNeedToSearchWallIndex();
+#endif
+	distIndexList.assign(path.getNeedToSearchIndex().begin(), path.getNeedToSearchIndex().end());
+}
+
+template<int N>
+void AgentT<N>::updateNeedToSearchIndex()
+{
+#if AGENT_SEARCH_TARGET == SEARCH_BY_TIME
+	path.retainNeedToSearchWallIndex();
+#else
+	path.calcNeedToSearchWallIndex();
+#endif
+}
+
+template<int N>
+IndexVec AgentT<N>::nearestDist(const IndexVec &cur) const
+{
+	if (maze->getStepMap(cur) == MazeT<N>::STEP_MAX) return cur;
+
+	//歩数マップを歩数0まで下る
+	IndexVec index = cur;
+	while (maze->getStepMap(index) != 0) {
+		const typename MazeT<N>::Step step = maze->getStepMap(index);
+		const Direction index_wall = maze->getWall(index);
+		for (int i=0;i<4;i++) {
+			if (index_wall[i] || !index.canSum(IndexVec::vecDir[i], N)) continue;
+			const IndexVec neighbor = index + IndexVec::vecDir[i];
+			if (maze->getStepMap(neighbor) == step-1) {
+				index = neighbor;
+				break;
+			}
+		}
+	}
+	return index;
+}
+
+
+#if AGENT_USE_SEARCH_TOUR
+template<int N>
+bool AgentT<N>::isCandidatePathOpen() const
+{
+#if AGENT_SEARCH_TARGET == SEARCH_BY_TIME
+	//走行時間で選ぶ場合は経路を1つに決めないので、探索する壁が全てわかるまで計算しなおさない
+	return true;
+#else
+	for (auto &p : path.getKShortestDistancePath()) {
+		for (size_t i=0;i+1<p.size();i++) {
+			const IndexVec diff = p[i+1] - p[i];
+			for (int j=0;j<4;j++) {
+				if (diff == IndexVec::vecDir[j] && maze->getWall(p[i])[j]) return false;
+			}
+		}
+	}
+	return true;
+#endif
+}
+
+template<int N>
+void AgentT<N>::planSearchTour(const IndexVec &cur)
+{
+	//暫定最短経路上の未探索壁のある座標を列挙し、回る順番を決める
+	calcNeedToSearchIndex();
+	if (!distIndexList.empty()) {
+		oracle.sync(*maze);
+		tour.plan(oracle, cur, distIndexList, AGENT_SEARCH_TOUR_BUDGET);
+		distIndexList = tour.getTour();
+	}
+	tourLegStep = MazeT<N>::STEP_MAX;
+}
+
+template<int N>
+void AgentT<N>::updateSearchTour(const IndexVec &cur)
+{
+	//未探索の壁は通れるものとして数えているので、暫定最短経路の上に壁が見つからない限り、暫定最短経路は最短のまま
+	//その間はk最短経路を計算しなおさず、壁が分かった座標を順番から除いていくだけでよい
+	bool replan = distIndexList.empty() || !isCandidatePathOpen();
+	if (!replan) {
+		updateNeedToSearchIndex();
+		oracle.sync(*maze);
+		if (tour.retain(oracle, path.getNeedToSearchIndex())) {
+			distIndexList = tour.getTour();
+			tourLegStep = MazeT<N>::STEP_MAX;
+		}
+		replan = distIndexList.empty() || calcNextDirection(cur, distIndexList.front()) == 0;
+	}
+
+	if (replan) {
+		planSearchTour(cur);
+	}
+	else if (maze->getStepMap(cur) > tourLegStep) {
+		//壁が増えて先頭の座標までの歩数が伸びたので、今の座標から順番を改善しなおす
+		tour.replan(oracle, cur, AGENT_SEARCH_TOUR_BUDGET);
+		distIndexList = tour.getTour();
+	}
+
+	if (distIndexList.empty()) {
+		dist = IndexVec(0,0);
+		state = AgentT::BACK_TO_START;
+		return;
+	}
+
+	//順番の先頭の座標に向かう
+	dist = distIndexList.front();
+	nextDir = calcNextDirection(cur, dist);
+	tourLegStep = maze->getStepMap(cur) - 1;
+}
+#endif
 
-void Agent::update(const IndexVec &cur, const Direction &cur_wall)
+template<int N>
+void AgentT<N>::update(const IndexVec &cur, const Direction &cur_wall)
 {
+	PROFILE_SCOPE(PROFILE_AGENT_UPDATE, (ProfilePoint)(PROFILE_AGENT_UPDATE_IDLE + state));
 	maze->updateWall(cur, cur_wall);
 
-	if (state == Agent::IDLE) {
+	if (state == AgentT::IDLE) {
 		distIndexList.clear();
-		distIndexList.assign(MAZE_GOAL_LIST);
+		distIndexList = goalList;
 
 		dist = distIndexList.front();
-		state = Agent::SEARCHING_NOT_GOAL;
+		state = AgentT::SEARCHING_NOT_GOAL;
 	}
 
-	if (state == Agent::SEARCHING_NOT_GOAL) {
+	if (state == AgentT::SEARCHING_NOT_GOAL) {
 		for (auto it = distIndexList.begin();it!=distIndexList.end();) {
 			if (*it == cur){
 				it = distIndexList.erase(it);
@@ -81,60 +221,43 @@ void Agent::update(const IndexVec &cur, const Direction &cur_wall)
 			it++;
 		}
 		if (distIndexList.empty()) {
-			state = Agent::SEARCHING_REACHED_GOAL;
-		}
-		else {
-			//distIndexListの中から現在座標に一番近い近いものをdistに入れる
-			int minDistance = INT32_MAX;
-			std::list<IndexVec>::iterator it_nearestDist;
-			maze->updateStepMap(cur);
-			for (auto it=distIndexList.begin();it!=distIndexList.end();it++) {
-				int stepDiff = maze->getStepMap(cur) - maze->getStepMap(*it);
-				if (stepDiff<0) stepDiff = -stepDiff;
-				if (stepDiff < minDistance) {
-					minDistance = stepDiff;
-					it_nearestDist = it;
-				}
-			}
-			dist = *it_nearestDist;
+			state = AgentT::SEARCHING_REACHED_GOAL;
 		}
 	}
 
 
-	if (state == Agent::SEARCHING_REACHED_GOAL) {
-		//distIndexListのどれかに到達した or 目標地点が到達不能だと分かったら更新
+	if (state == AgentT::SEARCHING_REACHED_GOAL) {
+#if AGENT_USE_SEARCH_TOUR
+		//決めた順番で目標座標を回る
+		updateSearchTour(cur);
+		if (state == AgentT::SEARCHING_REACHED_GOAL) return;
+#else
+		//distIndexListのどれかに到達した or 目標地点が全て到達不能だと分かったら更新
 		auto it = std::find(distIndexList.begin(), distIndexList.end(), cur);
-		if (it != distIndexList.end() || calcNextDirection(cur, dist) == 0) {
+		if (distIndexList.empty() || it != distIndexList.end() || calcNextDirection(cur, distIndexList) == 0) {
 			//暫定最短経路上の未探索壁のある座標を列挙
 			//それらの座標をdistIndexListにいれる
 			distIndexList.clear();
-			path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, SEARCH_DEPTH1, false);
-			path.calcNeedToSearchWallIndex();
-			distIndexList.assign(path.getNeedToSearchIndex().begin(), path.getNeedToSearchIndex().end());
+			calcNeedToSearchIndex();
 			if (distIndexList.empty()) {
-				distIndexList.push_back(IndexVec(0,0));
-				state = Agent::BACK_TO_START;
-			}
-		}
-		maze->updateStepMap(cur);
-
-		//distIndexListの中から現在座標に一番近い近いものをdistに入れる
-		int minDistance = INT32_MAX;
-		std::list<IndexVec>::iterator it_nearestDist;
-		for (auto it=distIndexList.begin();it!=distIndexList.end();it++) {
-			int stepDiff = maze->getStepMap(cur) - maze->getStepMap(*it);
-			if (stepDiff<0) stepDiff = -stepDiff;
-			if (stepDiff < minDistance) {
-				minDistance = stepDiff;
-				it_nearestDist = it;
+				dist = IndexVec(0,0);
+				state = AgentT::BACK_TO_START;
 			}
 		}
-		dist = *it_nearestDist;
+#endif
+	}
+
 
+	if (state == AgentT::SEARCHING_NOT_GOAL || state == AgentT::SEARCHING_REACHED_GOAL) {
+		//distIndexListの全ての座標から同時に歩数マップを広げ、一番近いものに向かう
+		//目標座標ごとに歩数マップを計算しなおさなくてよい
+		nextDir = calcNextDirection(cur, distIndexList);
+		dist = nearestDist(cur);
+		return;
 	}
 
 
-	if (state == Agent::BACK_TO_START) {
+	if (state == AgentT::BACK_TO_START) {
 		if (toDistinationPath.empty()) {
 			//現在地点からスタートまでの最短経路を計算する
 			path.calcShortestDistancePath(cur, IndexVec(0,0), true);
@@ -143,7 +266,7 @@ void Agent::update(const IndexVec &cur, const Direction &cur_wall)
 		}
 
 		if (dist == cur) {
-			state = Agent::FINISHED;
+			state = AgentT::FINISHED;
 			nextDir = 0;
 
 			return;
@@ -161,7 +284,7 @@ void Agent::update(const IndexVec &cur, const Direction &cur_wall)
 	}
 
 
-	if (state == Agent::FINISHED) {
+	if (state == AgentT::FINISHED) {
 
 	}
 
@@ -169,14 +292,21 @@ void Agent::update(const IndexVec &cur, const Direction &cur_wall)
 	nextDir = calcNextDirection(cur, dist);
 }
 
-void Agent::caclRunSequence(bool useDiagonalPath)
+template<int N>
+void AgentT<N>::caclRunSequence(bool useDiagonalPath, const RobotProfile &profile)
 {
-	if (state != Agent::FINISHED) return ;
-	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, SEARCH_DEPTH2, true, useDiagonalPath);
+	if (state != AgentT::FINISHED) return ;
+	PROFILE_SCOPE(PROFILE_RUN_SEQUENCE);
+#if RUN_SEQUENCE_METHOD == RUN_SEQUENCE_STATE_GRAPH
+	path.calcShortestTimePathByStateGraph(IndexVec(0,0), goalList, true, useDiagonalPath, profile);
+#else
+	path.calcShortestTimePath(IndexVec(0,0), goalList, SEARCH_DEPTH2, true, useDiagonalPath, profile);
+#endif
 }
 
 
-void Agent::resumeAt(State resumeState, Maze &_maze)
+template<int N>
+void AgentT<N>::resumeAt(State resumeState, MazeT<N> &_maze)
 {
 	reset();
 	*maze = _maze;
@@ -186,31 +316,25 @@ void Agent::resumeAt(State resumeState, Maze &_maze)
 	}
 
 	else if (resumeState == State::SEARCHING_NOT_GOAL) {
-		distIndexList.assign(MAZE_GOAL_LIST);
+		distIndexList = goalList;
 		dist = distIndexList.front();
 		state = State::SEARCHING_NOT_GOAL;
 	}
 
 	else if (resumeState == State::SEARCHING_REACHED_GOAL) {
+#if AGENT_USE_SEARCH_TOUR
+		//スタートから回る順番を決め、その先頭をdistに入れる
+		planSearchTour(IndexVec(0,0));
+		if (!distIndexList.empty()) dist = distIndexList.front();
+#else
 		//暫定最短経路上の未探索壁のある座標を列挙
 		//それらの座標をdistIndexListにいれる
-		maze->updateStepMap(IndexVec(0,0));
-		path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, SEARCH_DEPTH1, false);
-		path.calcNeedToSearchWallIndex();
-		distIndexList.assign(path.getNeedToSearchIndex().begin(), path.getNeedToSearchIndex().end());
-
-		//distIndexListの中から現在座標に一番近い近いものをdistに入れる
-		int minDistance = INT32_MAX;
-		std::list<IndexVec>::iterator it_nearestDist;
-		for (auto it=distIndexList.begin();it!=distIndexList.end();it++) {
-			int stepDiff = maze->getStepMap(IndexVec(0,0)) - maze->getStepMap(*it);
-			if (stepDiff<0) stepDiff = -stepDiff;
-			if (stepDiff < minDistance) {
-				minDistance = stepDiff;
-				it_nearestDist = it;
-			}
-		}
-		dist = *it_nearestDist;
+		calcNeedToSearchIndex();
+
+		//distIndexListの中からスタートに一番近いものをdistに入れる
+		maze->updateStepMap(distIndexList);
+		dist = nearestDist(IndexVec(0,0));
+#endif
 
 		state = State::SEARCHING_REACHED_GOAL;
 	}
@@ -224,3 +348,7 @@ void Agent::resumeAt(State resumeState, Maze &_maze)
 	}
 
 }
+
+//使う大きさの迷路の実体をつくる
+template class AgentT<16>;
+template class AgentT<32>;
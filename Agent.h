@@ -1,15 +1,16 @@
 #ifndef AGENT_H_
 #define AGENT_H_
 
-#include <list>
 #include <vector>
 
 #include "Maze.h"
 #include "ShortestPath.h"
+#include "DistanceOracle.h"
+#include "SearchTour.h"
 #include "Operation.h"
 
 /**************************************************************
- * Agent
+ * AgentT
  *	探索時にロボットに動きの指示を与える
  *	探索・最短経路の計算において最も上位に位置する
  *
@@ -17,8 +18,11 @@
  *	updateを実行すると次に進むべき方向が計算される
  *
  *	迷路情報は外に保存をするが、Agent::updateを通して更新をしていく
+ *
+ *	N:迷路の大きさ 普段はMAZE_SIZEの大きさのAgentを使う
  **************************************************************/
-class Agent {
+template<int N>
+class AgentT {
 public:
 	typedef enum {
 		IDLE, 					//まだ実行されていない
@@ -27,22 +31,43 @@ public:
 		BACK_TO_START, 			//スタートに戻っている
 		FINISHED 				//スタート地点に到着をし、最短経路の計算の準備ができた
 	} State;
+	typedef PathT<N> Path;
+	typedef IndexListT<N> IndexList;
 
 private:
-	Maze* maze;
+	MazeT<N>* maze;
 	State state;
 
+	//ゴール座標のリスト
+	IndexList goalList;
+
 	//現在目指している目標座標
 	IndexVec dist;
 
 	//目標座標リスト
-	std::list<IndexVec> distIndexList;
+	IndexList distIndexList;
 
 	//次にロボットが向かうべき方向(絶対座標)
 	Direction nextDir;
 
 	//最短経路の計算をするやつ
-	ShortestPath path;
+	ShortestPathT<N> path;
+
+#if AGENT_USE_DISTANCE_ORACLE
+	//区画の組の歩数 SearchTourで回る順番を決めるのに使う
+	DistanceOracleT<N> oracle;
+#endif
+#if AGENT_SEARCH_TARGET == SEARCH_BY_TIME
+	//探索中に走行時間を見積もる走行性能
+	const RobotProfile *searchProfile;
+	bool searchDiagonalPath;
+#endif
+#if AGENT_USE_SEARCH_TOUR
+	//追加で探索する座標を回る順番
+	SearchTourT<N> tour;
+	//次にいる座標で、順番の先頭の座標までの歩数がこれより大きければ順番を改善しなおす
+	typename MazeT<N>::Step tourLegStep;
+#endif
 
 	//目標地点への最短経路
 	//とりあえずはスタート地点に向かうときにだけつかう
@@ -52,14 +77,59 @@ private:
 
 	//足立法で次に進むべき方向を算出してくれる
 	Direction calcNextDirection(const IndexVec &cur, const IndexVec &dist);
+	//distListの全ての座標を歩数0にした歩数マップで、一番近い座標に向かう方向
+	//distListが変わらない間は歩数マップを差分更新だけで使い続けられる
+	Direction calcNextDirection(const IndexVec &cur, const IndexList &distList);
+	//今の歩数マップでcurから一番近い目標座標
+	//到達できない場合はcurを返す
+	IndexVec nearestDist(const IndexVec &cur) const;
+#if AGENT_USE_SEARCH_TOUR
+	//暫定最短経路が全て、見つかった壁にふさがれていなければtrue
+	bool isCandidatePathOpen() const;
+	//暫定最短経路上の未探索壁のある座標を、curから全て回る順番でdistIndexListに入れる 到達できない座標は除く
+	void planSearchTour(const IndexVec &cur);
+	//SEARCHING_REACHED_GOALで次に進む方向を決める 探索が終わったらBACK_TO_STARTにする
+	void updateSearchTour(const IndexVec &cur);
+#endif
+	//今の歩数マップで次に進むべき方向
+	Direction nextDirectionOnStepMap(const IndexVec &cur) const;
+	//暫定最短経路を計算しなおし、その上の未探索壁のある座標をdistIndexListに入れる
+	//暫定最短経路はAGENT_SEARCH_TARGETで選ぶ
+	void calcNeedToSearchIndex();
+	//暫定最短経路は計算しなおさず、その上の未探索壁のある座標をpath.getNeedToSearchIndex()に入れる
+	void updateNeedToSearchIndex();
 
 
 public:
-	Agent(Maze &_maze) :maze(&_maze), state(Agent::IDLE), path(_maze) { reset(); }
+	//ゴールはMAZE_GOAL_LIST(迷路の大きさがMAZE_SIZEでないときは中央の4区画)
+	AgentT(MazeT<N> &_maze) :maze(&_maze), state(AgentT::IDLE), goalList(defaultGoalList()), path(_maze) { setSearchProfile(true); reset(); }
+	//ゴール座標のリストを指定する
+	AgentT(MazeT<N> &_maze, const IndexList &_goalList) :maze(&_maze), state(AgentT::IDLE), goalList(_goalList), path(_maze) { setSearchProfile(true); reset(); }
+
+	static IndexList defaultGoalList()
+	{
+		if (N == MAZE_SIZE) return MAZE_GOAL_LIST;
+		return { IndexVec(N/2-1,N/2-1), IndexVec(N/2-1,N/2), IndexVec(N/2,N/2-1), IndexVec(N/2,N/2) };
+	}
+	inline const IndexList &getGoalList() const { return goalList; }
 
 	//状態をIDLEにし、path関連を全てクリアする
 	void reset();
 
+	//AGENT_SEARCH_TARGETがSEARCH_BY_TIMEのとき、探索中に走行時間を見積もる走行性能
+	//caclRunSequenceに渡すものと同じにしておく profileは探索が終わるまで残しておくこと
+	//デフォルトは斜め走行ありでRobotProfile::getDefault()
+	void setSearchProfile(bool useDiagonalPath, const RobotProfile &profile = RobotProfile::getDefault())
+	{
+#if AGENT_SEARCH_TARGET == SEARCH_BY_TIME
+		searchDiagonalPath = useDiagonalPath;
+		searchProfile = &profile;
+#else
+		(void)useDiagonalPath;
+		(void)profile;
+#endif
+	}
+
 	//状態を更新する
 	//cur:今の座標
 	//cur_wall:今の座標における壁情報(Done bitは無視される)
@@ -77,26 +147,30 @@ public:
 
 	//強制的にゴールに向かわせる
 	//探索に時間がかかりすぎている場合につかう(2分たったら呼び出すとか)
-	void forceGotoStart() { dist = IndexVec(0,0); state = Agent::BACK_TO_START; }
+	void forceGotoStart() { dist = IndexVec(0,0); state = AgentT::BACK_TO_START; }
 
 	//現在の目標地点を取得
 	inline const IndexVec& getDist() const { return dist; }
-	inline const std::list<IndexVec> &getDistList() const { return distIndexList; }
+	//AGENT_USE_SEARCH_TOUR(一旦ゴールに到達したあと)は回る順番に並んでいる
+	inline const IndexList &getDistList() const { return distIndexList; }
 
 	//現在のk最短経路の取得
 	inline const std::vector<Path> &getKShortestPath() const {return path.getKShortestDistancePath();}
 
 	//最終的に走る経路を計算する
 	//Agentの状態がFINISHEDになっている時に実行する
-	void caclRunSequence(bool useDiagonalPath);
+	//profileの走行性能で一番速い経路を選ぶ
+	void caclRunSequence(bool useDiagonalPath, const RobotProfile &profile = RobotProfile::getDefault());
 	inline const Path &getShortestPath() const {return path.getShortestTimePath();}
 	inline const OperationList &getRunSequence() const { return path.getShortestTimePathOperation(); }
 
 	//途中から再開する
 	//再開したいAgentと迷路の状態を渡す
-	void resumeAt(State resumeState, Maze &_maze);
+	void resumeAt(State resumeState, MazeT<N> &_maze);
 };
 
+typedef AgentT<MAZE_SIZE> Agent;
+
 
 
 #endif /* AGENT_H_ */
@@ -0,0 +1,117 @@
+#include "MazeSolver_conf.h"
+#include "DistanceOracle.h"
+
+
+template<int N>
+DistanceOracleT<N>::DistanceOracleT() : distance(N*N*N*N), rowValid(N*N, 0), wallVersion(0), synced(false), nRowCalc(0)
+{
+	for (int i=0;i<N*N;i++) wall[i] = 0;
+}
+
+template<int N>
+void DistanceOracleT<N>::invalidateAll()
+{
+	for (int s=0;s<N*N;s++) rowValid[s] = 0;
+}
+
+template<int N>
+void DistanceOracleT<N>::calcRow(int s)
+{
+	Step *row = &distance[s*N*N];
+	for (int i=0;i<N*N;i++) row[i] = MazeT<N>::STEP_MAX;
+	row[s] = 0;
+
+	//区画の番号(y*N+x)で幅優先探索する 外周は壁があることにしてあるので範囲の確認はいらない
+	//[0]:北 [1]:東 [2]:南 [3]:西
+	static const int offset[4] = { N, 1, -N, -1 };
+	uint16_t q[N*N];
+	int head = 0, tail = 0;
+	q[tail++] = s;
+	while (head < tail) {
+		const int cur = q[head++];
+		const Step next = row[cur] + 1;
+		const uint8_t cur_wall = wall[cur];
+		for (int i=0;i<4;i++) {
+			if (cur_wall & (1 << i)) continue;
+			const int neighbor = cur + offset[i];
+			if (row[neighbor] != MazeT<N>::STEP_MAX) continue;
+
+			row[neighbor] = next;
+			q[tail++] = neighbor;
+		}
+	}
+
+	rowValid[s] = 1;
+	nRowCalc++;
+}
+
+template<int N>
+void DistanceOracleT<N>::removeEdge(const IndexVec &a, int dir)
+{
+	//壁ができる前は隣どうしなので歩数の差は0か1
+	//差が1の行だけこの辺を最短経路に使っている可能性がある
+	const int ia = cellIndex(a);
+	const int ib = cellIndex(a + IndexVec::vecDir[dir]);
+	for (int s=0;s<N*N;s++) {
+		if (!rowValid[s]) continue;
+		const Step *row = &distance[s*N*N];
+		if (row[ia] != row[ib]) rowValid[s] = 0;
+	}
+}
+
+template<int N>
+void DistanceOracleT<N>::sync(const MazeT<N> &maze)
+{
+	if (synced && maze.getWallVersion() == wallVersion) return;
+
+	bool opened = !synced;
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			//外周の壁は必ずあることにする
+			uint8_t newWall = maze.getWall(x,y).byte & 0x0f;
+			if (y == N-1) newWall |= 0x01;
+			if (x == N-1) newWall |= 0x02;
+			if (y == 0) newWall |= 0x04;
+			if (x == 0) newWall |= 0x08;
+
+			uint8_t &oldWall = wall[cellIndex(IndexVec(x,y))];
+			const uint8_t added = newWall & ~oldWall;
+			if (oldWall & ~newWall) opened = true;
+			oldWall = newWall;
+
+			//辺は北と東だけ見れば1回ずつ調べられる
+			if (opened) continue;
+			for (int i=0;i<2;i++) {
+				if ((added & (1 << i)) && IndexVec(x,y).canSum(IndexVec::vecDir[i], N)) removeEdge(IndexVec(x,y), i);
+			}
+		}
+	}
+	if (opened) invalidateAll();
+
+	wallVersion = maze.getWallVersion();
+	synced = true;
+}
+
+template<int N>
+typename DistanceOracleT<N>::Step DistanceOracleT<N>::getDistance(const IndexVec &a, const IndexVec &b)
+{
+	const int ia = cellIndex(a);
+	const int ib = cellIndex(b);
+	if (rowValid[ib]) return distance[ib*N*N + ia];
+	if (rowValid[ia]) return distance[ia*N*N + ib];
+	calcRow(ib);
+	return distance[ib*N*N + ia];
+}
+
+template<int N>
+const typename DistanceOracleT<N>::Step *DistanceOracleT<N>::getRow(const IndexVec &from)
+{
+	const int s = cellIndex(from);
+	if (!rowValid[s]) calcRow(s);
+	return &distance[s*N*N];
+}
+
+//使う大きさの迷路の実体をつくる
+//16x16(クラシック)と32x32(ハーフサイズ)
+template class DistanceOracleT<16>;
+template class DistanceOracleT<32>;
@@ -0,0 +1,74 @@
+#ifndef DISTANCEORACLE_H_
+#define DISTANCEORACLE_H_
+
+#include <cstdint>
+#include <vector>
+#include "MazeSolver_conf.h"
+#include "Maze.h"
+
+
+/**************************************************************
+ * DistanceOracleT
+ *	迷路の全ての区画の組の歩数を覚えておき、表を引くだけで答える
+ *	区画sから全区画への歩数を1行として、使われた行だけを幅優先探索で計算する
+ *	歩数は未探索の壁は通れるものとして数える(updateStepMapのonlyUseFoundWall=falseと同じ)
+ *	N:迷路の大きさ
+ *
+ *	syncでMazeの壁情報に合わせる
+ *	壁が増えると歩数は増えることしかなく、増えるのはその壁の両側の歩数が違った(最短経路に使われていた)行だけなので、
+ *	その行だけを捨てて、次に使われたときに計算しなおす
+ *	壁は左右対称なので、歩数(s,t)はsの行とtの行のどちらかが計算済みなら表を引くだけになる
+ *
+ *	表はN*N行N*N列で、16x16は64KB、32x32は2MB(最初にヒープに確保する)
+ *
+ *	使い方
+ *	DistanceOracle oracle;
+ *	oracle.sync(maze);
+ *	oracle.getDistance(IndexVec(0,0), IndexVec(7,7));
+ **************************************************************/
+template<int N>
+class DistanceOracleT {
+public:
+	typedef typename MazeT<N>::Step Step;
+
+private:
+	//distance[s*N*N + t]:区画sから区画tへの歩数(到達できない場合はSTEP_MAX)
+	//rowValid[s]がfalseの行はまだ計算していない
+	std::vector<Step> distance;
+	std::vector<uint8_t> rowValid;
+
+	//最後にsyncしたときの壁(下位4bit)とMazeのwallVersion
+	//[y*N+x]が区画(x,y)の壁 外周は壁がなくても壁があることにする
+	uint8_t wall[N*N];
+	uint32_t wallVersion;
+	bool synced;
+
+	//行を計算した回数
+	uint32_t nRowCalc;
+
+	static inline int cellIndex(const IndexVec &index) { return index.y*N + index.x; }
+	void calcRow(int s);
+	void invalidateAll();
+	//aのdir方向に壁が増えたとき、歩数が変わるかもしれない行を捨てる
+	void removeEdge(const IndexVec &a, int dir);
+
+public:
+	DistanceOracleT();
+
+	//mazeの壁情報に合わせる
+	//前回から増えた壁だけを調べる 壁が減っている場合(別の迷路を読み込んだ時など)は全て捨てる
+	//何回分の壁の更新をまとめてsyncしてもよいので、歩数を使う直前に呼べばよい
+	void sync(const MazeT<N> &maze);
+
+	//aからbへの歩数 どちらの行も計算していなければbの行を計算する
+	Step getDistance(const IndexVec &a, const IndexVec &b);
+	//fromから全区画への歩数の行 [y*N+x]が区画(x,y)への歩数
+	const Step *getRow(const IndexVec &from);
+
+	inline uint32_t getRowCalcCount() const { return nRowCalc; }
+};
+
+typedef DistanceOracleT<MAZE_SIZE> DistanceOracle;
+
+
+#endif /* DISTANCEORACLE_H_ */
@@ -0,0 +1,131 @@
+#ifndef FIXEDVECTOR_H_
+#define FIXEDVECTOR_H_
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+
+
+/**************************************************************
+ * FixedVector
+ *	最大要素数がCAPACITYで決まっているvector
+ *	領域を最初から全部持っておき、ヒープを使わない
+ *	std::vectorとおんなじようなインターフェース
+ *	CAPACITYを超えてpush_backするとassertで止まる(NDEBUGのときは超えた分を捨てる 呼ぶ側で超えないようにする)
+ **************************************************************/
+template<class T, size_t CAPACITY>
+class FixedVector {
+private:
+	T data[CAPACITY];
+	size_t n;
+
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef const T& const_reference;
+
+	FixedVector() : n(0) {}
+	FixedVector(std::initializer_list<T> init) : n(0) { assign(init.begin(), init.end()); }
+	template<class InputIterator>
+	FixedVector(InputIterator first, InputIterator last) : n(0) { assign(first, last); }
+	//使っている分だけコピーする
+	FixedVector(const FixedVector &obj) : n(0) { assign(obj.begin(), obj.end()); }
+
+	const FixedVector &operator=(const FixedVector &rhs)
+	{
+		if (this != &rhs) assign(rhs.begin(), rhs.end());
+		return (*this);
+	}
+
+	template<class InputIterator>
+	void assign(InputIterator first, InputIterator last)
+	{
+		n = 0;
+		for (;first != last;first++) push_back(*first);
+	}
+
+	inline iterator begin() { return data; }
+	inline iterator end() { return data + n; }
+	inline const_iterator begin() const { return data; }
+	inline const_iterator end() const { return data + n; }
+
+	inline size_t size() const { return n; }
+	inline static size_t capacity() { return CAPACITY; }
+	inline bool empty() const { return n == 0; }
+	inline void clear() { n = 0; }
+
+	inline void push_back(const T &value)
+	{
+		assert(n < CAPACITY);
+		if (n < CAPACITY) data[n++] = value;
+	}
+	inline void pop_back() { n--; }
+
+	inline T &operator[](size_t i) { return data[i]; }
+	inline const T &operator[](size_t i) const { return data[i]; }
+	inline T &front() { return data[0]; }
+	inline const T &front() const { return data[0]; }
+	inline T &back() { return data[n-1]; }
+	inline const T &back() const { return data[n-1]; }
+
+	//後ろを詰める
+	iterator erase(iterator pos)
+	{
+		for (iterator it = pos;it+1 != end();it++) *it = *(it+1);
+		n--;
+		return pos;
+	}
+
+	void swap(FixedVector &obj)
+	{
+		FixedVector tmp(obj);
+		obj = *this;
+		*this = tmp;
+	}
+
+	bool operator==(const FixedVector &rhs) const
+	{
+		if (n != rhs.n) return false;
+		for (size_t i=0;i<n;i++) {
+			if (!(data[i] == rhs.data[i])) return false;
+		}
+		return true;
+	}
+	inline bool operator!=(const FixedVector &rhs) const { return !(*this == rhs); }
+};
+
+
+/**************************************************************
+ * FixedQueue
+ *	最大要素数がCAPACITYで決まっているリングバッファのqueue
+ *	std::queueとおんなじようなインターフェース
+ *	CAPACITYを超えてpushするとassertで止まる(NDEBUGのときは超えた分を捨てる 呼ぶ側で超えないようにする)
+ **************************************************************/
+template<class T, size_t CAPACITY>
+class FixedQueue {
+private:
+	T data[CAPACITY];
+	size_t head;
+	size_t n;
+
+public:
+	FixedQueue() : head(0), n(0) {}
+
+	inline bool empty() const { return n == 0; }
+	inline size_t size() const { return n; }
+	inline void push(const T &value)
+	{
+		assert(n < CAPACITY);
+		if (n < CAPACITY) data[(head + n++)%CAPACITY] = value;
+	}
+	inline const T &front() const { return data[head]; }
+	inline void pop()
+	{
+		head = (head + 1)%CAPACITY;
+		n--;
+	}
+};
+
+
+#endif /* FIXEDVECTOR_H_ */
@@ -1,7 +1,18 @@
 #include <cstdio>
-#include <queue>
+#include <cstdarg>
+#include <cstring>
+#include <vector>
 
 #include "Maze.h"
+#include "Profiler.h"
+
+#if MAZE_STEPMAP_METHOD == STEPMAP_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#endif
 
 const uint8_t NORTH = 0x01;
 const uint8_t EAST = 0x02;
@@ -18,95 +29,304 @@ const IndexVec IndexVec::vecSouth(0,-1);
 const IndexVec IndexVec::vecWest(-1,0);
 const IndexVec IndexVec::vecDir[4] = {IndexVec::vecNorth, IndexVec::vecEast, IndexVec::vecSouth, IndexVec::vecWest};
 
-void Maze::clear()
+template<int N>
+void MazeT<N>::clear()
 {
-	for (int i=0;i<MAZE_SIZE;i++) {
-		for (int j=0;j<MAZE_SIZE;j++) {
+	for (int i=0;i<N;i++) {
+		for (int j=0;j<N;j++) {
 			wall[i][j] = 0;
 		}
 	}
-	for (int i=0;i<MAZE_SIZE;i++) {
-		wall[MAZE_SIZE-1][i] |= NORTH | DONE_NORTH;
-		wall[i][MAZE_SIZE-1] |= EAST | DONE_EAST;
+	for (int i=0;i<N;i++) {
+		wall[N-1][i] |= NORTH | DONE_NORTH;
+		wall[i][N-1] |= EAST | DONE_EAST;
 		wall[0][i] |= SOUTH | DONE_SOUTH;
 		wall[i][0] |= WEST | DONE_WEST;
 	}
 
-	dirty = true;
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+	for (int i=0;i<N;i++) {
+		for (int j=0;j<N;j++) {
+			syncBitBoard(IndexVec(j,i));
+		}
+	}
+#endif
+
+	invalidateStepMap();
 }
 
-bool Maze::loadFromFile(const char *_filename)
+//迷路ファイルの文字を数値にする表 16進数の文字以外は-1
+static const int8_t hexTable[256] = {
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,-1,-1,-1,-1,-1,-1,
+	-1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+static inline bool isSpace(char ch)
 {
-	dirty = true;
+	return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+/**************************************************************
+ * MazeFileReader
+ *	迷路ファイルの中身を先頭から読んでいき、エラーのときに場所(行、列)を出せるように数えておく
+ **************************************************************/
+class MazeFileReader {
+private:
+	const char *buffer;
+	size_t length;
+	size_t pos;
+	int line;
+	int column;
+
+public:
+	const char *filename;
+
+	MazeFileReader(const char *_buffer, size_t _length, const char *_filename)
+		: buffer(_buffer), length(_length), pos(0), line(1), column(1), filename(_filename) {}
+
+	inline bool eof() const { return pos >= length; }
+	inline char peek() const { return buffer[pos]; }
+	inline size_t position() const { return pos; }
+	inline void next()
+	{
+		if (buffer[pos] == '\n') {
+			line++;
+			column = 1;
+		}
+		else column++;
+		pos++;
+	}
+	inline void skipSpace() { while (!eof() && isSpace(peek())) next(); }
+
+	//10進数の数字を読む 数字がなければfalse
+	bool readInt(int &value)
+	{
+		skipSpace();
+		if (eof() || peek() < '0' || '9' < peek()) return false;
+		value = 0;
+		while (!eof() && '0' <= peek() && peek() <= '9') {
+			value = value*10 + (peek() - '0');
+			next();
+		}
+		return true;
+	}
 
+	//壁情報の文字を読み飛ばしてcnt番目(0から)の壁情報の場所まで進む
+	void seekCell(size_t start, size_t cnt)
+	{
+		pos = 0; line = 1; column = 1;
+		while (!eof() && pos < start) next();
+		for (;;) {
+			skipSpace();
+			if (eof() || cnt == 0) return;
+			next();
+			cnt--;
+		}
+	}
+
+	void error(const char *format, ...) const
+	{
+		std::fprintf(stderr, "ERROR : %s:%d:%d: ", filename, line, column);
+		va_list args;
+		va_start(args, format);
+		std::vfprintf(stderr, format, args);
+		va_end(args);
+		std::fprintf(stderr, "\n");
+	}
+};
+
+template<int N>
+bool MazeT<N>::loadFromFile(const char *_filename)
+{
+	//ファイル全体を一度に読み込む
 	FILE *inputFile;
-	inputFile = std::fopen(_filename, "r");
+	inputFile = std::fopen(_filename, "rb");
 	if (inputFile == NULL) {
-		std::printf("ERROR : Failed open wall data file\n");
+		std::fprintf(stderr, "ERROR : %s: Failed open wall data file\n", _filename);
 		return false;
 	}
 
+	std::vector<char> buffer;
+	char chunk[4096];
+	size_t nRead;
+	while ((nRead = std::fread(chunk, 1, sizeof(chunk), inputFile)) > 0) {
+		buffer.insert(buffer.end(), chunk, chunk + nRead);
+	}
+	const bool readError = std::ferror(inputFile);
+	std::fclose(inputFile);
+	if (readError) {
+		std::fprintf(stderr, "ERROR : %s: Failed read wall data\n", _filename);
+		return false;
+	}
+
+	return loadFromBuffer(buffer.data(), buffer.size(), _filename);
+}
+
+template<int N>
+bool MazeT<N>::loadFromBuffer(const char *buffer, size_t length, const char *_filename)
+{
+	MazeFileReader reader(buffer, length, _filename);
+
+	//先頭の3つの数字 2つ目と3つ目が迷路の大きさ
+	int header[3];
 	for (int i=0;i<3;i++) {
-		int dummy;
-		if (std::fscanf(inputFile, "%d", &dummy) == EOF) {
-			std::printf("ERROR : Failed read wall data\n");
-			std::fclose(inputFile);
+		if (!reader.readInt(header[i])) {
+			reader.error("Failed read wall data header");
 			return false;
 		}
 	}
+	if (header[1] != N || header[2] != N) {
+		reader.error("maze size %dx%d does not match %dx%d", header[1], header[2], N, N);
+		return false;
+	}
 
+	//壁情報 全部読めるまでは迷路を書き換えない
+	uint8_t wallData[N][N];
+	const size_t start = reader.position();
 	size_t cnt = 0;
-	char ch;
-	while (std::fscanf(inputFile, "%c", &ch) != EOF) {
-		if ( ('0' <= ch && ch <= '9') || ('a' <= ch && ch <= 'f')) {
-			uint8_t wall_bin;
-			if ('0' <= ch && ch <= '9') wall_bin = ch - '0';
-			else wall_bin = ch - 'a' + 10;
+	for (reader.skipSpace();!reader.eof();reader.skipSpace()) {
+		const int8_t wall_bin = hexTable[(uint8_t)reader.peek()];
+		if (wall_bin < 0) {
+			reader.error("unexpected character '%c'", reader.peek());
+			return false;
+		}
+		if (cnt >= (size_t)N*N) {
+			reader.error("too many cells (expected %d)", N*N);
+			return false;
+		}
+		wallData[N-1 -cnt/N][cnt%N] = wall_bin;
+		cnt++;
+		reader.next();
+	}
+	if (cnt != (size_t)N*N) {
+		reader.error("too few cells (expected %d, found %lu)", N*N, (unsigned long)cnt);
+		return false;
+	}
 
-			size_t y = MAZE_SIZE -1 -cnt/MAZE_SIZE;
-			size_t x = cnt%MAZE_SIZE;
-			wall[y][x].byte = wall_bin | 0xf0;
-			cnt++;
+	//外周に壁があって、隣り合う区画で壁が食い違っていないか
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			const uint8_t w = wallData[y][x];
+			const char *message = NULL;
+			if (y == N-1 && !(w & NORTH)) message = "no outer wall on north";
+			else if (x == N-1 && !(w & EAST)) message = "no outer wall on east";
+			else if (y == 0 && !(w & SOUTH)) message = "no outer wall on south";
+			else if (x == 0 && !(w & WEST)) message = "no outer wall on west";
+			else if (y < N-1 && !(w & NORTH) != !(wallData[y+1][x] & SOUTH)) message = "north wall does not match the cell above";
+			else if (x < N-1 && !(w & EAST) != !(wallData[y][x+1] & WEST)) message = "east wall does not match the cell on the right";
+
+			if (message != NULL) {
+				reader.seekCell(start, (size_t)(N-1-y)*N + x);
+				reader.error("cell (%d,%d): %s", x, y, message);
+				return false;
+			}
+		}
+	}
+
+	invalidateStepMap();
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			wall[y][x].byte = wallData[y][x] | 0xf0;
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+			syncBitBoard(IndexVec(x,y));
+#endif
 		}
 	}
-	std::fclose(inputFile);
 
 	return true;
 }
 
 
-void Maze::loadFromArray(const char asciiData[MAZE_SIZE+1][MAZE_SIZE+1])
+template<int N>
+bool MazeT<N>::saveToFile(const char *_filename) const
 {
-	dirty = true;
+	FILE *outputFile;
+	outputFile = std::fopen(_filename, "w");
+	if (outputFile == NULL) {
+		std::fprintf(stderr, "ERROR : %s: Failed open wall data file\n", _filename);
+		return false;
+	}
 
-	for (int i=0;i<MAZE_SIZE;i++) {
-		for (int j=0;j<MAZE_SIZE;j++) {
-			char ch = asciiData[MAZE_SIZE-1-i][j];
+	//maze_data/*.datと同じ並び
+	//先頭に3つの数字(0と迷路の大きさ)、迷路を実際に見た時と同じ並びの壁情報(16進数)、最後に空行
+	std::fprintf(outputFile, "0\n%d\n%d\n", N, N);
+	for (int y=N-1;y>=0;y--) {
+		for (int x=0;x<N;x++) {
+			std::fprintf(outputFile, "%x%s", wall[y][x].byte & 0x0f, (x == N-1) ? "\n" : " ");
+		}
+	}
+	std::fprintf(outputFile, "\n");
+	std::fclose(outputFile);
+
+	return true;
+}
+
+template<int N>
+void MazeT<N>::loadFromArray(const char asciiData[N+1][N+1])
+{
+	invalidateStepMap();
+
+	for (int i=0;i<N;i++) {
+		for (int j=0;j<N;j++) {
+			char ch = asciiData[N-1-i][j];
 			if ( ('0' <= ch && ch <= '9') || ('a' <= ch && ch <= 'f')) {
 				uint8_t wall_bin;
 				if ('0' <= ch && ch <= '9') wall_bin = ch - '0';
 				else wall_bin = ch - 'a' + 10;
 
 				wall[i][j].byte = wall_bin | 0xf0;
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+				syncBitBoard(IndexVec(j,i));
+#endif
 			}
 		}
 	}
 }
 
-void Maze::printWall(const uint8_t value[MAZE_SIZE][MAZE_SIZE]) const
+template<int N>
+void MazeT<N>::loadFromImage(const MazeImageT<N> &image)
+{
+	invalidateStepMap();
+
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			wall[y][x].byte = image.get(x,y);
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+			syncBitBoard(IndexVec(x,y));
+#endif
+		}
+	}
+}
+
+template<int N>
+void MazeT<N>::printWall(const Step value[N][N]) const
 {
 	bool printValueOn = false;
 	if (value) printValueOn = true;
 
-	for (int y=MAZE_SIZE-1;y>=0;y--) {
-		for (int x=0;x<MAZE_SIZE;x++) {
+	for (int y=N-1;y>=0;y--) {
+		for (int x=0;x<N;x++) {
 			std::printf("+");
 			if(wall[y][x].bits.North) std::printf("----");
 			else std::printf("    ");
 		}
 		std::printf("+\n");
 
-		for (int x=0;x<MAZE_SIZE;x++) {
+		for (int x=0;x<N;x++) {
 			if (wall[y][x].bits.West) std::printf("|");
 			else std::printf(" ");
 			std::printf(" ");
@@ -115,7 +335,7 @@ void Maze::printWall(const uint8_t value[MAZE_SIZE][MAZE_SIZE]) const
 		}
 		std::printf("|\n");
 	}
-	for (int i=0;i<MAZE_SIZE;i++) {
+	for (int i=0;i<N;i++) {
 		std::printf("-----");
 	}
 	std::printf("+\n");
@@ -123,20 +343,21 @@ void Maze::printWall(const uint8_t value[MAZE_SIZE][MAZE_SIZE]) const
 
 
 
-void Maze::printWall(const bool value[MAZE_SIZE][MAZE_SIZE]) const
+template<int N>
+void MazeT<N>::printWall(const bool value[N][N]) const
 {
 	bool printValueOn = false;
 	if (value) printValueOn = true;
 
-	for (int y=MAZE_SIZE-1;y>=0;y--) {
-		for (int x=0;x<MAZE_SIZE;x++) {
+	for (int y=N-1;y>=0;y--) {
+		for (int x=0;x<N;x++) {
 			std::printf("+");
 			if(wall[y][x].bits.North) std::printf("----");
 			else std::printf("    ");
 		}
 		std::printf("+\n");
 
-		for (int x=0;x<MAZE_SIZE;x++) {
+		for (int x=0;x<N;x++) {
 			if (wall[y][x].bits.West) std::printf("|");
 			else std::printf(" ");
 			std::printf("  ");
@@ -148,56 +369,189 @@ void Maze::printWall(const bool value[MAZE_SIZE][MAZE_SIZE]) const
 		}
 		std::printf("|\n");
 	}
-	for (int i=0;i<MAZE_SIZE;i++) {
+	for (int i=0;i<N;i++) {
 		std::printf("-----");
 	}
 	std::printf("+\n");
 }
 
-void Maze::printStepMap() const
+template<int N>
+void MazeT<N>::printStepMap() const
 {
 	printWall(stepMap);
 }
 
-void Maze::updateWall(const IndexVec &cur, const Direction& newState, bool forceSetDone)
+template<int N>
+void MazeT<N>::addChangedIndex(const IndexVec &index)
+{
+	wallVersion++;
+
+	//全体を再計算する予定ならば記録する必要はない
+	if (dirty) return;
+
+	if (nChangedIndex >= STEPMAP_REPAIR_BUFFER_SIZE) {
+		dirty = true;
+		return;
+	}
+	changedIndex[nChangedIndex++] = index;
+}
+
+template<int N>
+void MazeT<N>::updateWall(const IndexVec &cur, const Direction& newState, bool forceSetDone)
 {
 	//二重書き込みを防ぐ
 	if (!forceSetDone && wall[cur.y][cur.x].isDoneAll()) return;
 
-	dirty = true;
+	const uint8_t prevWall = wall[cur.y][cur.x];
 	if (forceSetDone) wall[cur.y][cur.x] |= newState | (uint8_t)0xf0;
 	else wall[cur.y][cur.x] |= newState;
+	if (wall[cur.y][cur.x] != prevWall) {
+		addChangedIndex(cur);
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+		syncBitBoard(cur);
+#endif
+	}
 
 	//今のEASTをx+1のWESTに反映
 	//今のNORTHをy+1のSOUTHに反映
 	//今のWESTをx-1のEASTに反映
 	//今のSOUTHをy-1のNORTHに反映
 	for (int i=0;i<4;i++) {
-		if (cur.canSum(IndexVec::vecDir[i])) {
+		if (cur.canSum(IndexVec::vecDir[i], N)) {
 			IndexVec neighbor(cur + IndexVec::vecDir[i]);
+			const uint8_t prevNeighborWall = wall[neighbor.y][neighbor.x];
 			//今のi番目の壁情報ビットとDoneビットを(i+2)%4番目(180度回転方向)に反映
 			if (forceSetDone) wall[neighbor.y][neighbor.x] |= (0x10 | newState[i]) << (i+2)%4;
 			else wall[neighbor.y][neighbor.x] |= ((newState[i+4]<<4) | newState[i]) << (i+2)%4;
+			if (wall[neighbor.y][neighbor.x] != prevNeighborWall) {
+				addChangedIndex(neighbor);
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+				syncBitBoard(neighbor);
+#endif
+			}
 		}
 	}
 }
 
-void Maze::updateStepMap(const IndexVec &dist, bool onlyUseFoundWall)
+template<int N>
+void MazeT<N>::updateStepMap(const IndexVec &dist, bool onlyUseFoundWall)
+{
+	DistSet distSet;
+	distSet.set(dist);
+	updateStepMap(distSet, onlyUseFoundWall);
+}
+
+template<int N>
+void MazeT<N>::updateStepMap(const IndexListT<N> &distList, bool onlyUseFoundWall)
+{
+	DistSet distSet;
+	for (const IndexVec &index : distList) distSet.set(index);
+	updateStepMap(distSet, onlyUseFoundWall);
+}
+
+template<int N>
+void MazeT<N>::updateStepMap(const DistSet &dist, bool onlyUseFoundWall)
 {
-	if (!dirty && dist == lastStepMapDist && onlyUseFoundWall == lastOnlyUseFoundWall) return;
+	PROFILE_SCOPE(PROFILE_MAZE_UPDATE_STEPMAP);
+	if (!dirty && dist == lastStepMapDist && onlyUseFoundWall == lastOnlyUseFoundWall) {
+		//壁の変化した部分のまわりだけ修復する
+		if (nChangedIndex != 0) repairStepMap(onlyUseFoundWall);
+		nChangedIndex = 0;
+		return;
+	}
+
+#if STEPMAP_CACHE_SIZE > 0
+	//今の歩数マップは目標座標を戻したときに使えるようにキャッシュに入れておく
+	//計算してから壁が変わっている場合は、入れても使われないので入れない
+	if (!dirty && nChangedIndex == 0) storeStepMapCache();
+	if (loadStepMapCache(dist, onlyUseFoundWall)) {
+		lastStepMapDist = dist;
+		lastOnlyUseFoundWall = onlyUseFoundWall;
+		dirty = false;
+		nChangedIndex = 0;
+		return;
+	}
+#endif
+
 	lastStepMapDist = dist;
 	lastOnlyUseFoundWall = onlyUseFoundWall;
 	dirty = false;
+	nChangedIndex = 0;
+
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+	calcStepMapByBitBoard(dist, onlyUseFoundWall);
+#elif MAZE_STEPMAP_METHOD == STEPMAP_SIMD
+	calcStepMapBySIMD(dist, onlyUseFoundWall);
+#else
+	calcStepMapByQueue(dist, onlyUseFoundWall);
+#endif
+}
+
+template<int N>
+void MazeT<N>::clearStepMapCache()
+{
+#if STEPMAP_CACHE_SIZE > 0
+	for (int i=0;i<STEPMAP_CACHE_SIZE;i++) stepMapCache[i].valid = false;
+	stepMapCacheClock = 0;
+#endif
+}
+
+#if STEPMAP_CACHE_SIZE > 0
+template<int N>
+void MazeT<N>::storeStepMapCache()
+{
+	//同じ目標座標のもの、空いているもの、一番長く使っていないものの順に上書きする
+	StepMapCache *entry = &stepMapCache[0];
+	for (int i=0;i<STEPMAP_CACHE_SIZE;i++) {
+		StepMapCache &cache = stepMapCache[i];
+		if (cache.valid && cache.dist == lastStepMapDist && cache.onlyUseFoundWall == lastOnlyUseFoundWall) {
+			entry = &cache;
+			break;
+		}
+		if (!entry->valid) continue;
+		if (!cache.valid || cache.lastUsed < entry->lastUsed) entry = &cache;
+	}
+
+	entry->dist = lastStepMapDist;
+	entry->onlyUseFoundWall = lastOnlyUseFoundWall;
+	entry->valid = true;
+	entry->wallVersion = wallVersion;
+	entry->lastUsed = ++stepMapCacheClock;
+	std::memcpy(entry->stepMap, stepMap, sizeof(stepMap));
+}
 
-	for(size_t i=0;i<MAZE_SIZE;i++) {
-		for(size_t j=0;j<MAZE_SIZE;j++) {
-			stepMap[i][j] = 0xff;
+template<int N>
+bool MazeT<N>::loadStepMapCache(const DistSet &dist, bool onlyUseFoundWall)
+{
+	for (int i=0;i<STEPMAP_CACHE_SIZE;i++) {
+		StepMapCache &cache = stepMapCache[i];
+		if (!cache.valid || cache.wallVersion != wallVersion) continue;
+		if (cache.onlyUseFoundWall != onlyUseFoundWall || cache.dist != dist) continue;
+
+		cache.lastUsed = ++stepMapCacheClock;
+		std::memcpy(stepMap, cache.stepMap, sizeof(stepMap));
+		return true;
+	}
+	return false;
+}
+#endif
+
+template<int N>
+void MazeT<N>::calcStepMapByQueue(const DistSet &dist, bool onlyUseFoundWall)
+{
+	for(size_t i=0;i<N;i++) {
+		for(size_t j=0;j<N;j++) {
+			stepMap[i][j] = STEP_MAX;
 		}
 	}
-	stepMap[dist.y][dist.x] = 0;
 
-	std::queue<IndexVec> q;
-	q.push(dist);
+	//各座標は一度しか入らないので、迷路の区画数分あれば足りる
+	//目標座標を全て歩数0で入れておくと、一番近い目標座標からの歩数になる
+	FixedQueue<IndexVec, N*N> q;
+	dist.forEach([this, &q](const IndexVec &index) {
+		stepMap[index.y][index.x] = 0;
+		q.push(index);
+	});
 
 	while (!q.empty()) {
 		const IndexVec cur = q.front();
@@ -206,7 +560,7 @@ void Maze::updateStepMap(const IndexVec &dist, bool onlyUseFoundWall)
 		Direction cur_wall = wall[cur.y][cur.x];
 		for (int i=0;i<4;i++) {
 			const IndexVec scanIndex = cur + IndexVec::vecDir[i];
-			const uint8_t curStep = stepMap[cur.y][cur.x];
+			const Step curStep = stepMap[cur.y][cur.x];
 			if (!cur_wall[i] && stepMap[scanIndex.y][scanIndex.x] > curStep +1) {
 				//未探索壁をどうするか
 				if (onlyUseFoundWall && !cur_wall[i+4]) continue;
@@ -221,3 +575,384 @@ void Maze::updateStepMap(const IndexVec &dist, bool onlyUseFoundWall)
 		}
 	}
 }
+
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+template<int N>
+void MazeT<N>::syncBitBoard(const IndexVec &index)
+{
+	const Direction &index_wall = wall[index.y][index.x];
+	for (int i=0;i<4;i++) {
+		wallPlane[i].set(index, index_wall[i]);
+		donePlane[i].set(index, index_wall[i+4]);
+	}
+}
+
+template<int N>
+void MazeT<N>::calcStepMapByBitBoard(const DistSet &dist, bool onlyUseFoundWall)
+{
+	//各方角に進める区画
+	BitBoard<N> canMove[4];
+	for (int i=0;i<4;i++) {
+		canMove[i] = ~wallPlane[i];
+		//未探索壁をどうするか
+		if (onlyUseFoundWall) canMove[i] &= donePlane[i];
+	}
+	//東西の端から外に出て隣の行に回り込まないようにする
+	canMove[1] &= ~BitBoard<N>::columnMask(N-1);
+	canMove[3] &= ~BitBoard<N>::columnMask(0);
+
+	//袋小路(壁が3つ)の区画からは歩数を広げない
+	//ただし目標座標は除く
+	const BitBoard<N> &n = wallPlane[0], &e = wallPlane[1], &s = wallPlane[2], &w = wallPlane[3];
+	const BitBoard<N> deadEnd = (n & e & s & ~w) | (n & e & ~s & w) | (n & ~e & s & w) | (~n & e & s & w);
+	BitBoard<N> reached;
+	dist.forEach([&reached](const IndexVec &index) { reached.set(index); });
+	const BitBoard<N> expandable = ~deadEnd | reached;
+
+	for(size_t i=0;i<N;i++) {
+		for(size_t j=0;j<N;j++) {
+			stepMap[i][j] = STEP_MAX;
+		}
+	}
+	dist.forEach([this](const IndexVec &index) { stepMap[index.y][index.x] = 0; });
+
+	BitBoard<N> front = reached;
+
+	//1歩ずつ全区画まとめて広げる
+	Step *stepMapArray = &stepMap[0][0];
+	Step step = 0;
+	while (!front.isZero()) {
+		step++;
+		front &= expandable;
+
+		BitBoard<N> next;
+		for (int i=0;i<4;i++) {
+			next |= (front & canMove[i]).shift(i);
+		}
+		next &= ~reached;
+		reached |= next;
+
+		next.forEach([stepMapArray, step](int index){ stepMapArray[index] = step; });
+		front = next;
+	}
+}
+#endif
+
+#if MAZE_STEPMAP_METHOD == STEPMAP_SIMD
+namespace {
+
+/**************************************************************
+ * StepRowOps
+ *	歩数マップの1行(N個のStep)をまとめて扱う演算
+ *	x=0の区画が先頭に入る
+ *	16x16(8bit)はSSE2、32x32(16bit)はAVX2で特殊化している
+ *	それ以外は普通のループで同じ計算をする
+ **************************************************************/
+template<int N, class Step>
+struct StepRowOps {
+	struct Row { Step v[N]; };
+
+	static inline Row load(const Step *p) { Row res; for (int i=0;i<N;i++) res.v[i] = p[i]; return res; }
+	static inline void store(Step *p, const Row &row) { for (int i=0;i<N;i++) p[i] = row.v[i]; }
+	static inline Row loadWall(const Direction *p) { Row res; for (int i=0;i<N;i++) res.v[i] = p[i].byte; return res; }
+	static inline Row set(Step value) { Row res; for (int i=0;i<N;i++) res.v[i] = value; return res; }
+	static inline Row andRow(const Row &a, const Row &b) { Row res; for (int i=0;i<N;i++) res.v[i] = a.v[i] & b.v[i]; return res; }
+	static inline Row orRow(const Row &a, const Row &b) { Row res; for (int i=0;i<N;i++) res.v[i] = a.v[i] | b.v[i]; return res; }
+	static inline Row minRow(const Row &a, const Row &b) { Row res; for (int i=0;i<N;i++) res.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return res; }
+	static inline Row addsRow(const Row &a, const Row &b)
+	{
+		Row res;
+		for (int i=0;i<N;i++) res.v[i] = (Step)(a.v[i] + b.v[i]) < a.v[i] ? (Step)~0 : a.v[i] + b.v[i];
+		return res;
+	}
+	static inline Row subRow(const Row &a, const Row &b) { Row res; for (int i=0;i<N;i++) res.v[i] = a.v[i] - b.v[i]; return res; }
+	static inline Row eqRow(const Row &a, const Row &b) { Row res; for (int i=0;i<N;i++) res.v[i] = a.v[i] == b.v[i] ? (Step)~0 : 0; return res; }
+	static inline bool same(const Row &a, const Row &b) { for (int i=0;i<N;i++) if (a.v[i] != b.v[i]) return false; return true; }
+	//x-1の値をxに移す(x=0には0が入る)
+	static inline Row shiftEast(const Row &row) { Row res; res.v[0] = 0; for (int i=1;i<N;i++) res.v[i] = row.v[i-1]; return res; }
+	//x+1の値をxに移す(x=N-1には0が入る)
+	static inline Row shiftWest(const Row &row) { Row res; for (int i=0;i<N-1;i++) res.v[i] = row.v[i+1]; res.v[N-1] = 0; return res; }
+};
+
+#if defined(__SSE2__)
+template<>
+struct StepRowOps<16, uint8_t> {
+	typedef __m128i Row;
+
+	static inline Row load(const uint8_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+	static inline void store(uint8_t *p, const Row &row) { _mm_storeu_si128((__m128i *)p, row); }
+	static inline Row loadWall(const Direction *p) { return _mm_loadu_si128((const __m128i *)&p->byte); }
+	static inline Row set(uint8_t value) { return _mm_set1_epi8((char)value); }
+	static inline Row andRow(const Row &a, const Row &b) { return _mm_and_si128(a, b); }
+	static inline Row orRow(const Row &a, const Row &b) { return _mm_or_si128(a, b); }
+	static inline Row minRow(const Row &a, const Row &b) { return _mm_min_epu8(a, b); }
+	static inline Row addsRow(const Row &a, const Row &b) { return _mm_adds_epu8(a, b); }
+	static inline Row subRow(const Row &a, const Row &b) { return _mm_sub_epi8(a, b); }
+	static inline Row eqRow(const Row &a, const Row &b) { return _mm_cmpeq_epi8(a, b); }
+	static inline bool same(const Row &a, const Row &b) { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff; }
+	static inline Row shiftEast(const Row &row) { return _mm_slli_si128(row, 1); }
+	static inline Row shiftWest(const Row &row) { return _mm_srli_si128(row, 1); }
+};
+#endif
+
+#if defined(__AVX2__)
+template<>
+struct StepRowOps<32, uint16_t> {
+	//x=0~15をlo、x=16~31をhiに入れる
+	struct Row { __m256i lo, hi; };
+
+	static inline Row load(const uint16_t *p) { return Row{_mm256_loadu_si256((const __m256i *)p), _mm256_loadu_si256((const __m256i *)(p+16))}; }
+	static inline void store(uint16_t *p, const Row &row) { _mm256_storeu_si256((__m256i *)p, row.lo); _mm256_storeu_si256((__m256i *)(p+16), row.hi); }
+	static inline Row loadWall(const Direction *p)
+	{
+		return Row{_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)&p[0].byte)), _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)&p[16].byte))};
+	}
+	static inline Row set(uint16_t value) { return Row{_mm256_set1_epi16((short)value), _mm256_set1_epi16((short)value)}; }
+	static inline Row andRow(const Row &a, const Row &b) { return Row{_mm256_and_si256(a.lo, b.lo), _mm256_and_si256(a.hi, b.hi)}; }
+	static inline Row orRow(const Row &a, const Row &b) { return Row{_mm256_or_si256(a.lo, b.lo), _mm256_or_si256(a.hi, b.hi)}; }
+	static inline Row minRow(const Row &a, const Row &b) { return Row{_mm256_min_epu16(a.lo, b.lo), _mm256_min_epu16(a.hi, b.hi)}; }
+	static inline Row addsRow(const Row &a, const Row &b) { return Row{_mm256_adds_epu16(a.lo, b.lo), _mm256_adds_epu16(a.hi, b.hi)}; }
+	static inline Row subRow(const Row &a, const Row &b) { return Row{_mm256_sub_epi16(a.lo, b.lo), _mm256_sub_epi16(a.hi, b.hi)}; }
+	static inline Row eqRow(const Row &a, const Row &b) { return Row{_mm256_cmpeq_epi16(a.lo, b.lo), _mm256_cmpeq_epi16(a.hi, b.hi)}; }
+	static inline bool same(const Row &a, const Row &b)
+	{
+		return (_mm256_movemask_epi8(_mm256_cmpeq_epi16(a.lo, b.lo)) & _mm256_movemask_epi8(_mm256_cmpeq_epi16(a.hi, b.hi))) == -1;
+	}
+	static inline Row shiftEast(const Row &row) { return Row{fromPrev(row.lo, _mm256_setzero_si256()), fromPrev(row.hi, row.lo)}; }
+	static inline Row shiftWest(const Row &row) { return Row{fromNext(row.lo, row.hi), fromNext(row.hi, _mm256_setzero_si256())}; }
+
+private:
+	//curを1区画分x正方向にずらし、空いたところにprevの最後の区画を入れる
+	static inline __m256i fromPrev(const __m256i &cur, const __m256i &prev) { return _mm256_alignr_epi8(cur, _mm256_permute2x128_si256(prev, cur, 0x21), 14); }
+	//curを1区画分x負方向にずらし、空いたところにnextの最初の区画を入れる
+	static inline __m256i fromNext(const __m256i &cur, const __m256i &next) { return _mm256_alignr_epi8(_mm256_permute2x128_si256(cur, next, 0x21), cur, 2); }
+};
+#endif
+
+//fromの区画から1歩で進めるならstepを更新する
+//blockedが全bit1の区画は進めない
+template<class Ops>
+inline typename Ops::Row relaxRow(const typename Ops::Row &step, const typename Ops::Row &from, const typename Ops::Row &blocked)
+{
+	return Ops::minRow(step, Ops::orRow(Ops::addsRow(from, Ops::set(1)), blocked));
+}
+
+}
+
+template<int N>
+void MazeT<N>::calcStepMapBySIMD(const DistSet &dist, bool onlyUseFoundWall)
+{
+	typedef StepRowOps<N, Step> Ops;
+	typedef typename Ops::Row Row;
+	const Row zero = Ops::set(0);
+	const Row full = Ops::set(STEP_MAX);
+
+	//blockedFrom[i][y]:i番目の方角の隣の区画から(x,y)に歩数を広げられないとき全bit1
+	//[0]:北 [1]:東 [2]:南 [3]:西
+	Row blockedFrom[4][N];
+	{
+		//まず各区画からi番目の方角に歩数を広げられないかどうかを行ごとに求める
+		Row blockedTo[4][N];
+
+		for (int y=0;y<N;y++) {
+			const Row wallRow = Ops::loadWall(wall[y]);
+			Row isWall[4];
+			Row nWall = zero;
+			for (int i=0;i<4;i++) {
+				const Row bit = Ops::set(0x01 << i);
+				isWall[i] = Ops::eqRow(Ops::andRow(wallRow, bit), bit);
+				//isWallは壁があると全bit1(-1)なので、引くと壁の数が数えられる
+				nWall = Ops::subRow(nWall, isWall[i]);
+			}
+			//袋小路(壁が3つ)の区画からは歩数を広げない
+			//ただし目標座標は除く
+			Row deadEnd = Ops::eqRow(nWall, Ops::set(3));
+			if (dist.row[y]) {
+				Step notDist[N];
+				for (int x=0;x<N;x++) notDist[x] = dist.contains(IndexVec(x,y)) ? 0 : STEP_MAX;
+				deadEnd = Ops::andRow(deadEnd, Ops::load(notDist));
+			}
+
+			for (int i=0;i<4;i++) {
+				blockedTo[i][y] = Ops::orRow(isWall[i], deadEnd);
+				//未探索壁をどうするか
+				if (onlyUseFoundWall) {
+					const Row doneBit = Ops::set(0x10 << i);
+					blockedTo[i][y] = Ops::orRow(blockedTo[i][y], Ops::eqRow(Ops::andRow(wallRow, doneBit), zero));
+				}
+			}
+		}
+
+		//隣の区画から見た値にずらす
+		//迷路の外からは広げられない
+		Step edge[N];
+		for (int x=0;x<N;x++) edge[x] = x == 0 ? STEP_MAX : 0;
+		const Row westEdge = Ops::load(edge);
+		for (int x=0;x<N;x++) edge[x] = x == N-1 ? STEP_MAX : 0;
+		const Row eastEdge = Ops::load(edge);
+		for (int y=0;y<N;y++) {
+			blockedFrom[0][y] = y < N-1 ? blockedTo[2][y+1] : full;
+			blockedFrom[1][y] = Ops::orRow(Ops::shiftWest(blockedTo[3][y]), eastEdge);
+			blockedFrom[2][y] = y > 0 ? blockedTo[0][y-1] : full;
+			blockedFrom[3][y] = Ops::orRow(Ops::shiftEast(blockedTo[1][y]), westEdge);
+		}
+	}
+
+	for(size_t i=0;i<N;i++) {
+		for(size_t j=0;j<N;j++) {
+			stepMap[i][j] = STEP_MAX;
+		}
+	}
+	dist.forEach([this](const IndexVec &index) { stepMap[index.y][index.x] = 0; });
+
+	Row row[N];
+	for (int y=0;y<N;y++) row[y] = Ops::load(stepMap[y]);
+
+	//行の中で東西方向に変化がなくなるまで広げる
+	auto relaxInRow = [&blockedFrom](Row cur, int y) {
+		Row prev;
+		do {
+			prev = cur;
+			cur = relaxRow<Ops>(cur, Ops::shiftEast(cur), blockedFrom[3][y]);
+			cur = relaxRow<Ops>(cur, Ops::shiftWest(cur), blockedFrom[1][y]);
+		} while (!Ops::same(cur, prev));
+		return cur;
+	};
+
+	//南から北、北から南に1行ずつ広げるのを、どの行も変化しなくなるまで繰り返す
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int y=0;y<N;y++) {
+			Row cur = row[y];
+			if (y > 0) cur = relaxRow<Ops>(cur, row[y-1], blockedFrom[2][y]);
+			cur = relaxInRow(cur, y);
+			if (!Ops::same(cur, row[y])) {
+				row[y] = cur;
+				changed = true;
+			}
+		}
+		for (int y=N-1;y>=0;y--) {
+			Row cur = row[y];
+			if (y < N-1) cur = relaxRow<Ops>(cur, row[y+1], blockedFrom[0][y]);
+			cur = relaxInRow(cur, y);
+			if (!Ops::same(cur, row[y])) {
+				row[y] = cur;
+				changed = true;
+			}
+		}
+	}
+
+	for (int y=0;y<N;y++) Ops::store(stepMap[y], row[y]);
+}
+#endif
+
+template<int N>
+bool MazeT<N>::hasStepMapSupport(const IndexVec &index, bool onlyUseFoundWall) const
+{
+	const Step step = stepMap[index.y][index.x];
+	for (int i=0;i<4;i++) {
+		if (!index.canSum(IndexVec::vecDir[i], N)) continue;
+		const IndexVec neighbor = index + IndexVec::vecDir[i];
+		if (stepMap[neighbor.y][neighbor.x] +1 != step) continue;
+
+		//neighborからindexへ進めるか(neighbor側の(i+2)%4番目の壁を見る)
+		const Direction &neighbor_wall = wall[neighbor.y][neighbor.x];
+		const int back = (i+2)%4;
+		if (neighbor_wall[back]) continue;
+		if (onlyUseFoundWall && !neighbor_wall[back+4]) continue;
+
+		//袋小路からは歩数が広がらない(目標座標は除く)
+		if (!lastStepMapDist.contains(neighbor) && neighbor_wall.nWall() == 3) continue;
+
+		return true;
+	}
+	return false;
+}
+
+template<int N>
+void MazeT<N>::repairStepMap(bool onlyUseFoundWall)
+{
+	//checkQueue:歩数の根拠を失ったかもしれない座標
+	//q:周りの歩数を小さくできるかもしれない座標
+	//どちらもqueueに入っている座標は入れないので、迷路の区画数分あれば足りる
+	FixedQueue<IndexVec, N*N> checkQueue;
+	FixedQueue<IndexVec, N*N> q;
+	bool inCheckQueue[N][N] = {};
+	bool inQueue[N][N] = {};
+	auto pushCheckQueue = [&](const IndexVec &index) {
+		if (inCheckQueue[index.y][index.x]) return;
+		inCheckQueue[index.y][index.x] = true;
+		checkQueue.push(index);
+	};
+	auto pushQueue = [&](const IndexVec &index) {
+		if (inQueue[index.y][index.x]) return;
+		inQueue[index.y][index.x] = true;
+		q.push(index);
+	};
+
+	for (int n=0;n<nChangedIndex;n++) {
+		const IndexVec &changed = changedIndex[n];
+		pushCheckQueue(changed);
+		pushQueue(changed);
+		for (int i=0;i<4;i++) {
+			if (!changed.canSum(IndexVec::vecDir[i], N)) continue;
+			pushCheckQueue(changed + IndexVec::vecDir[i]);
+			pushQueue(changed + IndexVec::vecDir[i]);
+		}
+	}
+
+	//壁が増えて通れなくなった部分
+	//1歩手前の区画から到達できなくなった座標の歩数を未到達(STEP_MAX)にし、
+	//その座標を根拠にしていた1歩先の座標も調べる
+	while (!checkQueue.empty()) {
+		const IndexVec cur = checkQueue.front();
+		checkQueue.pop();
+		inCheckQueue[cur.y][cur.x] = false;
+
+		const Step curStep = stepMap[cur.y][cur.x];
+		if (curStep == STEP_MAX || lastStepMapDist.contains(cur)) continue;
+		if (hasStepMapSupport(cur, onlyUseFoundWall)) continue;
+
+		stepMap[cur.y][cur.x] = STEP_MAX;
+		for (int i=0;i<4;i++) {
+			if (!cur.canSum(IndexVec::vecDir[i], N)) continue;
+			const IndexVec neighbor = cur + IndexVec::vecDir[i];
+			if (stepMap[neighbor.y][neighbor.x] == curStep +1) pushCheckQueue(neighbor);
+			pushQueue(neighbor);
+		}
+	}
+
+	//未到達にした部分と、壁が探索済みになって新しく通れるようになった部分に歩数を広げる
+	//処理の中身はupdateStepMapと同じ
+	while (!q.empty()) {
+		const IndexVec cur = q.front();
+		q.pop();
+		inQueue[cur.y][cur.x] = false;
+
+		const Step curStep = stepMap[cur.y][cur.x];
+		if (curStep == STEP_MAX) continue;
+		if (!lastStepMapDist.contains(cur) && wall[cur.y][cur.x].nWall() == 3) continue;
+
+		Direction cur_wall = wall[cur.y][cur.x];
+		for (int i=0;i<4;i++) {
+			const IndexVec scanIndex = cur + IndexVec::vecDir[i];
+			if (!cur_wall[i] && stepMap[scanIndex.y][scanIndex.x] > curStep +1) {
+				//未探索壁をどうするか
+				if (onlyUseFoundWall && !cur_wall[i+4]) continue;
+
+				stepMap[scanIndex.y][scanIndex.x] = curStep +1;
+
+				//袋小路でない場合はqueueに入れる
+				if (wall[scanIndex.y][scanIndex.x].nWall() != 3) {
+					pushQueue(scanIndex);
+				}
+			}
+		}
+	}
+}
+
+//使う大きさの迷路の実体をつくる
+//16x16(クラシック)と32x32(ハーフサイズ)
+template class MazeT<16>;
+template class MazeT<32>;
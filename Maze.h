@@ -3,7 +3,10 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <type_traits>
 #include "MazeSolver_conf.h"
+#include "FixedVector.h"
+#include "MazeImage.h"
 
 
 /**************************************************************
@@ -93,20 +96,21 @@ struct __attribute__ ((__packed__)) IndexVec {
 	inline bool operator!=(const IndexVec &obj) const { return x != obj.x || y != obj.y; }
 
 	//自分とobjを足しても迷路座標の範囲に収まるかどうか
-	inline bool canSum(const IndexVec &obj) const
+	//sizeは迷路の大きさ(MAZE_SIZE以外の大きさの迷路を扱うときに指定する)
+	inline bool canSum(const IndexVec &obj, int8_t size = MAZE_SIZE) const
 	{
 		const int8_t res_x = x + obj.x;
-		if (res_x<0 || MAZE_SIZE<=res_x) return false;
+		if (res_x<0 || size<=res_x) return false;
 		const int8_t res_y = y + obj.y;
-		if (res_y<0 || MAZE_SIZE<=res_y) return false;
+		if (res_y<0 || size<=res_y) return false;
 		return true;
 	}
-	inline bool canSub(const IndexVec &obj) const
+	inline bool canSub(const IndexVec &obj, int8_t size = MAZE_SIZE) const
 	{
 		const int8_t res_x = x - obj.x;
-		if (res_x<0 || MAZE_SIZE<=res_x) return false;
+		if (res_x<0 || size<=res_x) return false;
 		const int8_t res_y = y - obj.y;
-		if (res_y<0 || MAZE_SIZE<=res_y) return false;
+		if (res_y<0 || size<=res_y) return false;
 		return true;
 	}
 
@@ -125,7 +129,7 @@ struct __attribute__ ((__packed__)) IndexVec {
 		return x_abs == 1 && y_abs == 1;
 	}
 
-	inline bool isCorner(){ return x == MAZE_SIZE-1 || x == 0 || y == MAZE_SIZE-1 || y == 0; }
+	inline bool isCorner(int8_t size = MAZE_SIZE){ return x == size-1 || x == 0 || y == size-1 || y == 0; }
 
 	//便利な定数
 	//各方角を表すベクトル
@@ -137,44 +141,283 @@ struct __attribute__ ((__packed__)) IndexVec {
 	static const IndexVec vecDir[4];
 };
 
+/**************************************************************
+ * IndexListT, PathT
+ *	座標の並び 目標座標のリストや経路を表現するのに使う
+ *	同じ座標を2回通らない経路は迷路の区画数より長くならないので、
+ *	N*N個分の領域を持ったFixedVectorにしてヒープを使わないようにする
+ *	N:迷路の大きさ
+ **************************************************************/
+template<int N> using IndexListT = FixedVector<IndexVec, N*N>;
+template<int N> using PathT = FixedVector<IndexVec, N*N>;
+typedef IndexListT<MAZE_SIZE> IndexList;
+typedef PathT<MAZE_SIZE> Path;
+
+
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+/**************************************************************
+ * BitBoard
+ *	迷路の全区画を1区画1bitで表現する
+ *	N:迷路の大きさ
+ *	y*N+x番目のbitがIndexVec(x,y)の区画に対応する
+ *	歩数マップを計算するときに、全区画の1歩分をまとめてシフト・AND・ORで広げるのに使う
+ **************************************************************/
+template<int N>
+struct BitBoard {
+	static_assert(N < 64 && 64 % N == 0 && N*N % 64 == 0, "BitBoard supports maze size of 8, 16 or 32");
+	static const int N_WORD = N*N / 64;
+	uint64_t word[N_WORD];
+
+	BitBoard() { clear(); }
+	BitBoard(const BitBoard &obj) { for (int i=0;i<N_WORD;i++) word[i] = obj.word[i]; }
+	const BitBoard& operator=(const BitBoard &obj) { for (int i=0;i<N_WORD;i++) word[i] = obj.word[i]; return *this; }
+
+	inline void clear() { for (int i=0;i<N_WORD;i++) word[i] = 0; }
+	inline bool isZero() const
+	{
+		uint64_t res = 0;
+		for (int i=0;i<N_WORD;i++) res |= word[i];
+		return res == 0;
+	}
+
+	//1区画分のbitの読み書き
+	inline bool get(const IndexVec &index) const
+	{
+		const int n = index.y*N + index.x;
+		return (word[n/64] >> (n%64)) & 0x01;
+	}
+	inline void set(const IndexVec &index, bool value = true)
+	{
+		const int n = index.y*N + index.x;
+		if (value) word[n/64] |= (uint64_t)1 << (n%64);
+		else word[n/64] &= ~((uint64_t)1 << (n%64));
+	}
+
+	//bit演算
+	inline BitBoard operator&(const BitBoard &obj) const { BitBoard res; for (int i=0;i<N_WORD;i++) res.word[i] = word[i] & obj.word[i]; return res; }
+	inline BitBoard operator|(const BitBoard &obj) const { BitBoard res; for (int i=0;i<N_WORD;i++) res.word[i] = word[i] | obj.word[i]; return res; }
+	inline BitBoard operator~() const { BitBoard res; for (int i=0;i<N_WORD;i++) res.word[i] = ~word[i]; return res; }
+	inline void operator&=(const BitBoard &obj) { for (int i=0;i<N_WORD;i++) word[i] &= obj.word[i]; }
+	inline void operator|=(const BitBoard &obj) { for (int i=0;i<N_WORD;i++) word[i] |= obj.word[i]; }
+
+	//全区画を1区画分ずらす
+	//[0]:北 [1]:東 [2]:南 [3]:西 (IndexVec::vecDirと同じ順番)
+	//南北にはみ出した分は捨てられるが、東西にはみ出した分は隣の行に回り込むので
+	//呼ぶ側で端の列をcolumnMaskで落としておく
+	inline BitBoard shift(int dir) const
+	{
+		if (dir == 0) return shiftUp(N);
+		if (dir == 1) return shiftUp(1);
+		if (dir == 2) return shiftDown(N);
+		return shiftDown(1);
+	}
+
+	//x列目の区画だけbitが立っているBitBoard
+	static inline BitBoard columnMask(int x)
+	{
+		uint64_t pattern = 0;
+		for (int i=0;i<64;i+=N) pattern |= (uint64_t)1 << (i+x);
+		BitBoard res;
+		for (int i=0;i<N_WORD;i++) res.word[i] = pattern;
+		return res;
+	}
+
+	//立っているbitの区画ごとにfunc(bitの番号)を呼ぶ
+	template<class Func>
+	inline void forEach(Func func) const
+	{
+		for (int i=0;i<N_WORD;i++) {
+			uint64_t w = word[i];
+			while (w) {
+				func(i*64 + __builtin_ctzll(w));
+				w &= w-1;
+			}
+		}
+	}
+
+private:
+	inline BitBoard shiftUp(int n) const
+	{
+		BitBoard res;
+		for (int i=N_WORD-1;i>=0;i--) {
+			res.word[i] = word[i] << n;
+			if (i>0) res.word[i] |= word[i-1] >> (64-n);
+		}
+		return res;
+	}
+	inline BitBoard shiftDown(int n) const
+	{
+		BitBoard res;
+		for (int i=0;i<N_WORD;i++) {
+			res.word[i] = word[i] >> n;
+			if (i<N_WORD-1) res.word[i] |= word[i+1] << (64-n);
+		}
+		return res;
+	}
+};
+#endif
+
 
 /**************************************************************
- * Maze
+ * MazeT
  *	壁情報と歩数マップを保持する
  *	壁情報はMazeのupdateWallを使って更新をしていく
+ *	N:迷路の大きさ 普段はMAZE_SIZEの大きさのMazeを使う
+ *	16x16と32x32(ハーフサイズ)の実体をMaze.cppで作っている
  **************************************************************/
-class Maze {
+template<int N>
+class MazeT {
+public:
+	//歩数の型
+	//16x16までは8bitで足りるが、32x32だと最大の歩数が255を超える
+	typedef typename std::conditional<(N <= 16), uint8_t, uint16_t>::type Step;
+	//歩数マップで到達できない区画の値
+	static const Step STEP_MAX = (Step)~0;
+
+	/**************************************************************
+	 * DistSet
+	 *	歩数マップの目標座標(歩数が0の区画)の集合
+	 *	row[y]のx bit目が立っていればIndexVec(x,y)が目標座標
+	 *	区画ごとに目標座標かどうかをbit1つで引ける
+	 **************************************************************/
+	struct DistSet {
+		static_assert(N <= 32, "DistSet supports maze size up to 32");
+		uint32_t row[N];
+
+		DistSet() { clear(); }
+		inline void clear() { for (int i=0;i<N;i++) row[i] = 0; }
+		inline void set(const IndexVec &index) { row[index.y] |= (uint32_t)1 << index.x; }
+		inline bool contains(const IndexVec &index) const { return (row[index.y] >> index.x) & 0x01; }
+		inline bool operator==(const DistSet &obj) const
+		{
+			for (int i=0;i<N;i++) if (row[i] != obj.row[i]) return false;
+			return true;
+		}
+		inline bool operator!=(const DistSet &obj) const { return !(*this == obj); }
+
+		//目標座標ごとにfunc(IndexVec)を呼ぶ
+		template<class Func>
+		inline void forEach(Func func) const
+		{
+			for (int y=0;y<N;y++) {
+				uint32_t r = row[y];
+				while (r) {
+					func(IndexVec(__builtin_ctz(r), y));
+					r &= r-1;
+				}
+			}
+		}
+	};
+
 private:
-	Direction wall[MAZE_SIZE][MAZE_SIZE];
-	uint8_t stepMap[MAZE_SIZE][MAZE_SIZE];
+	Direction wall[N][N];
+	Step stepMap[N][N];
 
 	//無駄な計算をしないために、前回歩数マップを計算した時の情報を覚えとく
 	//もし前回と同じ状況ならば計算結果は変わらないので実行しない
 	bool dirty;
+	//壁情報が変わるたびに増える キャッシュした歩数マップが今の壁情報で計算したものかを見分ける
+	uint32_t wallVersion;
 	bool lastOnlyUseFoundWall;
-	IndexVec lastStepMapDist;
+	DistSet lastStepMapDist;
+
+	//前回歩数マップを計算してから壁情報が変化した座標
+	//目標座標が前回と同じならば、これらの座標のまわりだけ歩数マップを修復する
+	IndexVec changedIndex[STEPMAP_REPAIR_BUFFER_SIZE];
+	uint8_t nChangedIndex;
+
+	//壁情報が変化した座標をchangedIndexに記録する
+	//記録しきれない場合はdirtyにして全体を再計算させる
+	void addChangedIndex(const IndexVec &index);
+	//壁情報を全て書き換えたときに呼ぶ 歩数マップは全て計算しなおす
+	inline void invalidateStepMap() { dirty = true; wallVersion++; }
+
+#if STEPMAP_CACHE_SIZE > 0
+	//目標座標とonlyUseFoundWallごとの歩数マップ
+	//wallVersionが今と同じものだけを使う
+	struct StepMapCache {
+		DistSet dist;
+		bool onlyUseFoundWall;
+		bool valid;
+		uint32_t wallVersion;
+		//最後に使った時のstepMapCacheClock
+		uint32_t lastUsed;
+		Step stepMap[N][N];
+	};
+	StepMapCache stepMapCache[STEPMAP_CACHE_SIZE];
+	uint32_t stepMapCacheClock;
+
+	//今の歩数マップをキャッシュに入れる
+	void storeStepMapCache();
+	//キャッシュにあればstepMapにコピーしてtrueを返す
+	bool loadStepMapCache(const DistSet &dist, bool onlyUseFoundWall);
+#endif
+
+	//歩数マップの差分更新
+	//changedIndexのまわりで歩数が変わる部分だけを計算しなおす
+	void repairStepMap(bool onlyUseFoundWall);
+
+	//indexの歩数がいずれかの隣接区画から1歩で到達できる値になっているかどうか
+	bool hasStepMapSupport(const IndexVec &index, bool onlyUseFoundWall) const;
+
+	//歩数マップを全て計算しなおす
+	//MAZE_STEPMAP_METHODによってどれを使うかが切り替わる
+	//distの全ての座標を歩数0として同時に広げる
+	void calcStepMapByQueue(const DistSet &dist, bool onlyUseFoundWall);
+#if MAZE_STEPMAP_METHOD == STEPMAP_SIMD
+	void calcStepMapBySIMD(const DistSet &dist, bool onlyUseFoundWall);
+#endif
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+	void calcStepMapByBitBoard(const DistSet &dist, bool onlyUseFoundWall);
+
+	//wallを方角ごとにBitBoardにしたもの
+	//[0]:北 [1]:東 [2]:南 [3]:西
+	BitBoard<N> wallPlane[4];
+	BitBoard<N> donePlane[4];
+
+	//indexの壁情報をwallPlane,donePlaneに反映する
+	void syncBitBoard(const IndexVec &index);
+#endif
 
 public:
-	Maze() : dirty(true), lastOnlyUseFoundWall(true) { clear(); }
-	Maze(const Maze &obj) : dirty(true), lastOnlyUseFoundWall(true)
+	MazeT() : dirty(true), wallVersion(0), lastOnlyUseFoundWall(true), nChangedIndex(0)
+	{
+		clearStepMapCache();
+		clear();
+	}
+	MazeT(const MazeT &obj) : dirty(true), wallVersion(0), lastOnlyUseFoundWall(true), nChangedIndex(0)
 	{
-		for (int i=0;i<MAZE_SIZE;i++) {
-			for (int j=0;j<MAZE_SIZE;j++) {
+		clearStepMapCache();
+		for (int i=0;i<N;i++) {
+			for (int j=0;j<N;j++) {
 				wall[i][j] = obj.wall[i][j];
 				stepMap[i][j] = obj.stepMap[i][j];
 			}
 		}
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+		for (int i=0;i<4;i++) {
+			wallPlane[i] = obj.wallPlane[i];
+			donePlane[i] = obj.donePlane[i];
+		}
+#endif
 	}
 
-	const Maze& operator=(const Maze &obj)
+	const MazeT& operator=(const MazeT &obj)
 	{
-		dirty = true;
-		for (int i=0;i<MAZE_SIZE;i++) {
-			for (int j=0;j<MAZE_SIZE;j++) {
+		invalidateStepMap();
+		nChangedIndex = 0;
+		for (int i=0;i<N;i++) {
+			for (int j=0;j<N;j++) {
 				wall[i][j] = obj.wall[i][j];
 				stepMap[i][j] = obj.stepMap[i][j];
 			}
 		}
+#if MAZE_STEPMAP_METHOD == STEPMAP_BITBOARD
+		for (int i=0;i<4;i++) {
+			wallPlane[i] = obj.wallPlane[i];
+			donePlane[i] = obj.donePlane[i];
+		}
+#endif
 		return *this;
 	}
 
@@ -182,19 +425,30 @@ public:
 	void clear();
 
 	//ファイルから迷路をロードする
+	//ファイル全体を一度に読み込んでloadFromBufferで解釈する
 	bool loadFromFile(const char *_filename);
+	//メモリ上にある迷路ファイルの中身(lengthバイト)からロードする
+	//ヘッダの迷路の大きさがNと違う、区画の数が合わない、16進数以外の文字がある、
+	//隣り合う区画で壁が食い違っている、外周に壁がない場合は、場所(ファイル名:行:列)を標準エラーに出してfalseを返す
+	//falseのときは迷路を書き換えない
+	bool loadFromBuffer(const char *buffer, size_t length, const char *_filename = "");
+	//loadFromFileで読める形式でファイルに保存する
+	//探索済みbitは保存されない
+	bool saveToFile(const char *_filename) const;
 
 	//配列からロードする
 	//ロードするファイル、配列のデータの並びは迷路を実際に見た時と同じ並び方
 	//Maze.wallは上下が逆転しているから注意
-	//file[i][j] = ascii[i][j] = wall[MAZE_SIZE-1-i][j]
-	void loadFromArray(const char asciiData[MAZE_SIZE+1][MAZE_SIZE+1]);
+	//file[i][j] = ascii[i][j] = wall[N-1-i][j]
+	void loadFromArray(const char asciiData[N+1][N+1]);
+	//コンパイル時に解釈しておいた壁情報(MazeImage.h)をコピーする
+	void loadFromImage(const MazeImageT<N> &image);
 
 	//コンソール上にそれっぽく整形して迷路を表示する
 	//引数に数字の配列を渡すと各区画にその数字が表示される
-	void printWall(const uint8_t value[MAZE_SIZE][MAZE_SIZE] = nullptr) const;
+	void printWall(const Step value[N][N] = nullptr) const;
 	//引数にboolの配列を渡すと、trueの区画に*が表示される
-	void printWall(const bool value[MAZE_SIZE][MAZE_SIZE]) const;
+	void printWall(const bool value[N][N]) const;
 	//歩数マップを表示
 	void printStepMap() const;
 
@@ -213,17 +467,33 @@ public:
 	//適宜歩数マップが必要になるときにこれを呼んで歩数マップを更新してから参照する
 	//distの座標の歩数マップを0として計算する
 	//onlyUseFoundWall=trueにすると未探索の壁は通れないものとして歩数マップを計算する
+	//前回とdist,onlyUseFoundWallが同じで、壁の更新が少しだけの場合は差分だけ計算する
 	void updateStepMap(const IndexVec &dist, bool onlyUseFoundWall = false);
+	//distListの全ての座標を歩数0として計算する
+	//各区画の歩数はdistListの中で一番近い座標までの歩数になる
+	//前回とdistListの集合が同じ場合は、1つの座標の時と同じように差分だけ計算する
+	void updateStepMap(const IndexListT<N> &distList, bool onlyUseFoundWall = false);
+	void updateStepMap(const DistSet &dist, bool onlyUseFoundWall = false);
+	//キャッシュした歩数マップを全て捨てる
+	void clearStepMapCache();
 
 	//指定座標の壁情報を取得
 	inline const Direction &getWall(const IndexVec &index) const { return wall[index.y][index.x]; }
 	inline const Direction &getWall(int8_t x, int8_t y) const { return wall[y][x]; }
 
+	//壁情報が変わるたびに増える値
+	//壁情報を別に持っているもの(DistanceOracleなど)が、変化があったかを調べるのに使う
+	inline uint32_t getWallVersion() const { return wallVersion; }
+
 	//指定座標の歩数マップを取得
-	inline const uint8_t &getStepMap(const IndexVec &index) const { return stepMap[index.y][index.x]; }
-	inline const uint8_t &getStepMap(int8_t x, int8_t y) const { return stepMap[y][x]; }
+	inline const Step &getStepMap(const IndexVec &index) const { return stepMap[index.y][index.x]; }
+	inline const Step &getStepMap(int8_t x, int8_t y) const { return stepMap[y][x]; }
 
 };
 
+template<int N> const typename MazeT<N>::Step MazeT<N>::STEP_MAX;
+
+typedef MazeT<MAZE_SIZE> Maze;
+
 
 #endif /* MAZE_H_ */
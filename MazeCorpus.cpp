@@ -0,0 +1,238 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MAZECORPUS_USE_MMAP
+#endif
+
+#include "MazeSolver_conf.h"
+#include "MazeCorpus.h"
+
+static const char MAZECORPUS_MAGIC[4] = { 'M', 'Z', 'C', 'P' };
+static const uint16_t MAZECORPUS_VERSION = 1;
+static const size_t MAZECORPUS_HEADER_SIZE = 24;
+
+static inline uint16_t readU16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static inline uint32_t readU32(const uint8_t *p) { return readU16(p) | ((uint32_t)readU16(p+2) << 16); }
+static inline uint64_t readU64(const uint8_t *p) { return readU32(p) | ((uint64_t)readU32(p+4) << 32); }
+
+static inline void writeU16(uint8_t *p, uint16_t v) { p[0] = v & 0xff; p[1] = v >> 8; }
+static inline void writeU32(uint8_t *p, uint32_t v) { writeU16(p, v & 0xffff); writeU16(p+2, v >> 16); }
+static inline void writeU64(uint8_t *p, uint64_t v) { writeU32(p, v & 0xffffffff); writeU32(p+4, v >> 32); }
+
+//ゴールの区画の後ろを8byte境界まで埋めた、迷路が始まる位置
+static inline size_t recordStart(size_t nGoal) { return (MAZECORPUS_HEADER_SIZE + 2*nGoal + 7) / 8 * 8; }
+
+
+template<int N>
+void MazeViewT<N>::copyTo(MazeT<N> &maze) const
+{
+	maze.clear();
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			maze.updateWall(IndexVec(x,y), getWall(x,y), true);
+		}
+	}
+}
+
+
+template<int N>
+bool MazeCorpusT<N>::open(const char *filename)
+{
+	close();
+
+#ifdef MAZECORPUS_USE_MMAP
+	const int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) {
+		std::fprintf(stderr, "ERROR : %s: Failed open maze corpus\n", filename);
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		std::fprintf(stderr, "ERROR : %s: Failed read maze corpus\n", filename);
+		::close(fd);
+		return false;
+	}
+	void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) {
+		std::fprintf(stderr, "ERROR : %s: Failed map maze corpus\n", filename);
+		return false;
+	}
+	data = (const uint8_t *)p;
+	length = st.st_size;
+	mapped = true;
+#else
+	FILE *file = std::fopen(filename, "rb");
+	if (file == NULL) {
+		std::fprintf(stderr, "ERROR : %s: Failed open maze corpus\n", filename);
+		return false;
+	}
+	std::fseek(file, 0, SEEK_END);
+	const long fileSize = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+	uint8_t *buffer = (fileSize > 0) ? (uint8_t *)std::malloc(fileSize) : NULL;
+	if (buffer == NULL || std::fread(buffer, 1, fileSize, file) != (size_t)fileSize) {
+		std::fprintf(stderr, "ERROR : %s: Failed read maze corpus\n", filename);
+		std::free(buffer);
+		std::fclose(file);
+		return false;
+	}
+	std::fclose(file);
+	data = buffer;
+	length = fileSize;
+	mapped = false;
+#endif
+
+	//ヘッダの確認
+	const char *message = NULL;
+	if (length < MAZECORPUS_HEADER_SIZE || std::memcmp(data, MAZECORPUS_MAGIC, 4) != 0) {
+		message = "not a maze corpus";
+	}
+	else if (readU16(data + 4) != MAZECORPUS_VERSION) {
+		message = "unsupported version";
+	}
+	else if (readU16(data + 6) != N) {
+		message = "maze size does not match";
+	}
+	if (message == NULL) {
+		nMaze = readU32(data + 8);
+		const uint64_t indexOffset = readU64(data + 12);
+		const size_t nGoal = data[20];
+		if (recordStart(nGoal) > length) {
+			message = "truncated goal list";
+		}
+		else if (indexOffset > length || (length - indexOffset) / 8 < nMaze) {
+			message = "truncated index table";
+		}
+		else {
+			indexTable = data + indexOffset;
+			for (size_t i=0;i<nGoal;i++) {
+				goalList.push_back(IndexVec(data[MAZECORPUS_HEADER_SIZE + 2*i], data[MAZECORPUS_HEADER_SIZE + 2*i + 1]));
+			}
+			//全ての迷路がファイルの中に収まっているか
+			for (size_t i=0;i<nMaze;i++) {
+				const uint64_t offset = readU64(indexTable + 8*i);
+				if (offset > length || length - offset < (size_t)N*N/2) {
+					message = "truncated maze data";
+					break;
+				}
+			}
+		}
+	}
+	if (message != NULL) {
+		std::fprintf(stderr, "ERROR : %s: %s\n", filename, message);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+template<int N>
+void MazeCorpusT<N>::close()
+{
+	if (data != NULL) {
+#ifdef MAZECORPUS_USE_MMAP
+		if (mapped) munmap((void *)data, length);
+#endif
+		if (!mapped) std::free((void *)data);
+	}
+	data = NULL;
+	length = 0;
+	mapped = false;
+	nMaze = 0;
+	indexTable = NULL;
+	goalList.clear();
+}
+
+template<int N>
+MazeViewT<N> MazeCorpusT<N>::operator[](size_t i) const
+{
+	return MazeViewT<N>(data + readU64(indexTable + 8*i));
+}
+
+
+template<int N>
+bool MazeCorpusWriterT<N>::open(const char *filename, const IndexList &goalList)
+{
+	close();
+
+	file = std::fopen(filename, "wb");
+	if (file == NULL) {
+		std::fprintf(stderr, "ERROR : %s: Failed open maze corpus\n", filename);
+		return false;
+	}
+
+	//迷路の数とインデックス表の位置はcloseで埋める
+	const size_t nGoal = goalList.size() < 255 ? goalList.size() : 255;
+	uint8_t header[MAZECORPUS_HEADER_SIZE + 2*255 + 8] = {};
+	std::memcpy(header, MAZECORPUS_MAGIC, 4);
+	writeU16(header + 4, MAZECORPUS_VERSION);
+	writeU16(header + 6, N);
+	header[20] = nGoal;
+	for (size_t i=0;i<nGoal;i++) {
+		header[MAZECORPUS_HEADER_SIZE + 2*i] = goalList[i].x;
+		header[MAZECORPUS_HEADER_SIZE + 2*i + 1] = goalList[i].y;
+	}
+
+	pos = recordStart(nGoal);
+	offsets.clear();
+	return std::fwrite(header, 1, pos, file) == pos;
+}
+
+template<int N>
+bool MazeCorpusWriterT<N>::add(const MazeT<N> &maze)
+{
+	if (file == NULL) return false;
+
+	uint8_t record[N*N/2];
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x+=2) {
+			record[(y*N + x)/2] = (maze.getWall(x,y).byte & 0x0f) | ((maze.getWall(x+1,y).byte & 0x0f) << 4);
+		}
+	}
+	if (std::fwrite(record, 1, sizeof(record), file) != sizeof(record)) return false;
+
+	offsets.push_back(pos);
+	pos += sizeof(record);
+	return true;
+}
+
+template<int N>
+bool MazeCorpusWriterT<N>::close()
+{
+	if (file == NULL) return false;
+
+	bool ok = true;
+	uint8_t buf[8];
+	for (uint64_t offset : offsets) {
+		writeU64(buf, offset);
+		ok &= std::fwrite(buf, 1, 8, file) == 8;
+	}
+
+	writeU32(buf, offsets.size());
+	ok &= std::fseek(file, 8, SEEK_SET) == 0;
+	ok &= std::fwrite(buf, 1, 4, file) == 4;
+	writeU64(buf, pos);
+	ok &= std::fwrite(buf, 1, 8, file) == 8;
+
+	ok &= std::fclose(file) == 0;
+	file = NULL;
+	offsets.clear();
+	return ok;
+}
+
+//使う大きさの迷路の実体をつくる
+//16x16(クラシック)と32x32(ハーフサイズ)
+template class MazeViewT<16>;
+template class MazeViewT<32>;
+template class MazeCorpusT<16>;
+template class MazeCorpusT<32>;
+template class MazeCorpusWriterT<16>;
+template class MazeCorpusWriterT<32>;
@@ -0,0 +1,134 @@
+#ifndef MAZECORPUS_H_
+#define MAZECORPUS_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "MazeSolver_conf.h"
+#include "Maze.h"
+
+
+/**************************************************************
+ * 迷路コーパスのファイル形式(.mzc)
+ *	たくさんの迷路を1つのファイルにまとめたバイナリ形式 数値は全てリトルエンディアン
+ *
+ *	ヘッダ(24byte)
+ *	  0: "MZCP"
+ *	  4: uint16 バージョン(1)
+ *	  6: uint16 迷路の大きさN
+ *	  8: uint32 迷路の数
+ *	 12: uint64 インデックス表の位置(ファイル先頭からのbyte数)
+ *	 20: uint8  ゴールの区画の数
+ *	 21: 予約(0)
+ *	ゴールの区画 (x,y)をuint8で2byteずつ、8byte境界まで0で埋める
+ *	迷路 1つN*N/2byte 区画(x,y)の壁情報(下位4bit)が(y*N+x)/2byte目の、xが偶数なら下位4bit、奇数なら上位4bit
+ *	インデックス表 迷路ごとのファイル先頭からのbyte数をuint64で
+ **************************************************************/
+
+/**************************************************************
+ * MazeViewT
+ *	迷路コーパスの中の1つの迷路を、コピーせずにそのまま読むためのもの
+ *	壁は全て探索済みとして返す(loadFromFileと同じ)
+ *	元のMazeCorpusTをcloseするまで使える
+ **************************************************************/
+template<int N>
+class MazeViewT {
+private:
+	const uint8_t *data;
+
+public:
+	MazeViewT(const uint8_t *_data) : data(_data) {}
+
+	inline Direction getWall(int8_t x, int8_t y) const
+	{
+		const int i = y*N + x;
+		return Direction(0xf0 | ((data[i/2] >> (4*(i%2))) & 0x0f));
+	}
+	inline Direction getWall(const IndexVec &index) const { return getWall(index.x, index.y); }
+
+	//迷路をMazeにコピーする
+	void copyTo(MazeT<N> &maze) const;
+};
+
+
+/**************************************************************
+ * MazeCorpusT
+ *	迷路コーパスのファイルを開いて、中の迷路をMazeViewTとして読む
+ *	ファイルはmmapで開くので、迷路を読むときに解釈もメモリの確保もしない
+ *	(mmapがない環境ではファイル全体を読み込む)
+ **************************************************************/
+template<int N>
+class MazeCorpusT {
+public:
+	typedef IndexListT<N> IndexList;
+
+private:
+	const uint8_t *data;
+	size_t length;
+	bool mapped;
+	size_t nMaze;
+	const uint8_t *indexTable;
+	IndexList goalList;
+
+	MazeCorpusT(const MazeCorpusT &);
+	MazeCorpusT &operator=(const MazeCorpusT &);
+
+public:
+	MazeCorpusT() : data(NULL), length(0), mapped(false), nMaze(0), indexTable(NULL) {}
+	~MazeCorpusT() { close(); }
+
+	//ファイルを開く
+	//形式が違う、迷路の大きさがNと違う、途中で切れている場合は標準エラーに出してfalseを返す
+	bool open(const char *filename);
+	void close();
+
+	inline size_t size() const { return nMaze; }
+	inline const IndexList &getGoalList() const { return goalList; }
+	MazeViewT<N> operator[](size_t i) const;
+};
+
+
+/**************************************************************
+ * MazeCorpusWriterT
+ *	迷路コーパスのファイルを書く
+ *	迷路は1つずつファイルに追加していき、closeでインデックス表を書いてヘッダを埋める
+ *
+ *	使い方
+ *	MazeCorpusWriter writer;
+ *	writer.open("mazes.mzc", Agent::defaultGoalList());
+ *	writer.add(maze);
+ *	writer.close();
+ **************************************************************/
+template<int N>
+class MazeCorpusWriterT {
+public:
+	typedef IndexListT<N> IndexList;
+
+private:
+	FILE *file;
+	std::vector<uint64_t> offsets;
+	uint64_t pos;
+
+	MazeCorpusWriterT(const MazeCorpusWriterT &);
+	MazeCorpusWriterT &operator=(const MazeCorpusWriterT &);
+
+public:
+	MazeCorpusWriterT() : file(NULL), pos(0) {}
+	~MazeCorpusWriterT() { close(); }
+
+	bool open(const char *filename, const IndexList &goalList);
+	//迷路の壁情報(下位4bit)を追加する
+	bool add(const MazeT<N> &maze);
+	//インデックス表とヘッダを書いて閉じる
+	bool close();
+
+	inline size_t size() const { return offsets.size(); }
+};
+
+typedef MazeViewT<MAZE_SIZE> MazeView;
+typedef MazeCorpusT<MAZE_SIZE> MazeCorpus;
+typedef MazeCorpusWriterT<MAZE_SIZE> MazeCorpusWriter;
+
+
+#endif /* MAZECORPUS_H_ */
@@ -0,0 +1,338 @@
+#include <cstring>
+
+#include "MazeSolver_conf.h"
+#include "MazeGenerator.h"
+
+
+template<int N>
+void MazeGeneratorT<N>::setSeed(uint64_t seed)
+{
+	//近いシードでも違う系列になるようにかき混ぜる(splitmix64)
+	uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	state = z ^ (z >> 31);
+	//xorshiftは0からは抜け出せない
+	if (state == 0) state = 0x9E3779B97F4A7C15ULL;
+}
+
+template<int N>
+uint32_t MazeGeneratorT<N>::random(uint32_t n)
+{
+	//xorshift64*
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return (uint32_t)((state * 2685821657736338717ULL) >> 32) % n;
+}
+
+template<int N>
+void MazeGeneratorT<N>::setWall(const IndexVec &cur, int i, bool exist)
+{
+	//外周の壁はそのまま
+	if (!cur.canSum(IndexVec::vecDir[i], N)) return;
+
+	const IndexVec neighbor = cur + IndexVec::vecDir[i];
+	const int back = (i+2)%4;
+	if (exist) {
+		wall[cur.y][cur.x] |= 1 << i;
+		wall[neighbor.y][neighbor.x] |= 1 << back;
+	}
+	else {
+		wall[cur.y][cur.x] &= ~(1 << i);
+		wall[neighbor.y][neighbor.x] &= ~(1 << back);
+	}
+}
+
+template<int N>
+bool MazeGeneratorT<N>::isFixedWall(const IndexVec &cur, int i) const
+{
+	if (!cur.canSum(IndexVec::vecDir[i], N)) return true;
+
+	const IndexVec neighbor = cur + IndexVec::vecDir[i];
+	//スタートの東の壁
+	if ((cur == IndexVec(0,0) && neighbor == IndexVec(1,0)) || (cur == IndexVec(1,0) && neighbor == IndexVec(0,0))) return true;
+	//ゴールの周りの壁
+	if (isGoal(cur) != isGoal(neighbor)) return true;
+
+	return false;
+}
+
+template<int N>
+void MazeGeneratorT<N>::generatePerfect()
+{
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			wall[y][x] = 0x0f;
+		}
+	}
+
+	//穴掘り法
+	//スタートから掘り始め、まだ掘っていない区画へランダムに掘り進み、行き止まりになったら戻る
+	//ゴールの2x2区画はまとめて1つの区画として扱い、そこからは掘り進まない(入り口が1つになる)
+	bool visited[N][N] = {};
+	PathT<N> stack;
+	visited[0][0] = true;
+	stack.push_back(IndexVec(0,0));
+
+	while (!stack.empty()) {
+		const IndexVec cur = stack.back();
+
+		int candidate[4];
+		int nCandidate = 0;
+		for (int i=0;i<4;i++) {
+			if (!cur.canSum(IndexVec::vecDir[i], N)) continue;
+			const IndexVec neighbor = cur + IndexVec::vecDir[i];
+			if (visited[neighbor.y][neighbor.x]) continue;
+			//スタートの東は壁
+			if (cur == IndexVec(0,0) && i == 1) continue;
+			candidate[nCandidate++] = i;
+		}
+		if (nCandidate == 0) {
+			stack.pop_back();
+			continue;
+		}
+
+		const int dir = candidate[random(nCandidate)];
+		const IndexVec next = cur + IndexVec::vecDir[dir];
+		setWall(cur, dir, false);
+
+		if (isGoal(next)) {
+			for (int y=N/2-1;y<=N/2;y++) {
+				for (int x=N/2-1;x<=N/2;x++) {
+					visited[y][x] = true;
+				}
+			}
+			continue;
+		}
+		visited[next.y][next.x] = true;
+		stack.push_back(next);
+	}
+
+	//ゴールの中の壁を取り除く
+	for (int k=N/2-1;k<=N/2;k++) {
+		setWall(IndexVec(N/2-1, k), 1, false);
+		setWall(IndexVec(k, N/2-1), 0, false);
+	}
+}
+
+template<int N>
+void MazeGeneratorT<N>::addLoop(int nRemove, int nGoalEntrance)
+{
+	//ランダムに選んだ壁を取り除いてループを作る
+	for (int attempt=0;attempt<20*nRemove && nRemove>0;attempt++) {
+		const IndexVec cur(random(N), random(N));
+		//北か東の壁を選ぶ
+		const int dir = random(2);
+		if (!(wall[cur.y][cur.x] & (1 << dir))) continue;
+		if (isFixedWall(cur, dir)) continue;
+
+		setWall(cur, dir, false);
+		nRemove--;
+	}
+
+	//ゴールの入り口を増やす
+	//ゴールの各区画の外側の2辺が入り口の候補
+	IndexVec entranceIndex[8];
+	int entranceDir[8];
+	int nEntrance = 0;
+	int nCandidate = 0;
+	for (int y=N/2-1;y<=N/2;y++) {
+		for (int x=N/2-1;x<=N/2;x++) {
+			const IndexVec cur(x, y);
+			for (int i=0;i<4;i++) {
+				if (isGoal(cur + IndexVec::vecDir[i])) continue;
+				if (wall[y][x] & (1 << i)) {
+					entranceIndex[nCandidate] = cur;
+					entranceDir[nCandidate] = i;
+					nCandidate++;
+				}
+				else {
+					nEntrance++;
+				}
+			}
+		}
+	}
+	while (nEntrance < nGoalEntrance && nCandidate > 0) {
+		const int k = random(nCandidate);
+		setWall(entranceIndex[k], entranceDir[k], false);
+		entranceIndex[k] = entranceIndex[nCandidate-1];
+		entranceDir[k] = entranceDir[nCandidate-1];
+		nCandidate--;
+		nEntrance++;
+	}
+}
+
+template<int N>
+void MazeGeneratorT<N>::addDiagonal(int nStair)
+{
+	//ランダムな区画から、直交する2方向に交互に壁を取り除いて階段状の通路を掘る
+	//スタートの東の壁とゴールの周りの壁に当たったらそこでやめる
+	for (int k=0;k<nStair;k++) {
+		IndexVec cur(random(N), random(N));
+		const int dir0 = random(4);
+		const int dir1 = (dir0 + (random(2) ? 1 : 3))%4;
+		const int length = 6 + random(N);
+
+		for (int j=0;j<length;j++) {
+			const int dir = (j%2 == 0) ? dir0 : dir1;
+			if (isFixedWall(cur, dir)) break;
+			setWall(cur, dir, false);
+			cur += IndexVec::vecDir[dir];
+		}
+	}
+}
+
+template<int N>
+IndexVec MazeGeneratorT<N>::ringIndex(int layer, int i) const
+{
+	const int x0 = N/2-1 - layer;
+	const int x1 = N/2 + layer;
+	const int side = i / (2*layer + 1);
+	const int offset = i % (2*layer + 1);
+	switch (side) {
+	case 0: return IndexVec(x0, x0 + offset); 	//西の辺を北へ
+	case 1: return IndexVec(x0 + offset, x1); 	//北の辺を東へ
+	case 2: return IndexVec(x1, x1 - offset); 	//東の辺を南へ
+	default: return IndexVec(x1 - offset, x0); 	//南の辺を西へ
+	}
+}
+
+template<int N>
+void MazeGeneratorT<N>::generateAdversarial()
+{
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			wall[y][x] = 0x0f;
+		}
+	}
+	for (int k=N/2-1;k<=N/2;k++) {
+		setWall(IndexVec(N/2-1, k), 1, false);
+		setWall(IndexVec(k, N/2-1), 0, false);
+	}
+
+	//外側の輪から順に、入ってきた区画(entry)から出口(exit)を決めて内側の輪につなぐ
+	//一番外側の輪はスタート(南西の角)から入る
+	int entry = 0;
+	for (int layer=N/2-1;layer>=1;layer--) {
+		const int size = ringSize(layer);
+
+		//輪の通路
+		for (int i=0;i<size;i++) {
+			const IndexVec cur = ringIndex(layer, i);
+			const IndexVec dxdy = ringIndex(layer, (i+1)%size) - cur;
+			for (int dir=0;dir<4;dir++) {
+				if (dxdy == IndexVec::vecDir[dir]) setWall(cur, dir, false);
+			}
+		}
+
+		//出口は角以外(角からは内側の輪に隣接しない)
+		//入口から時計回りにdistance区画進んだところ
+		//一番外側はスタートの東の壁で反時計回りには進めないので、時計回りに半周以上
+		//それ以外は3/8周から半周のところに、時計回りか反時計回りで置く
+		int exit = 0;
+		int distance = 0;
+		for (int attempt=0;attempt<100;attempt++) {
+			if (layer == N/2-1) {
+				distance = size/2 + random(size/2 - 1);
+			}
+			else {
+				distance = size*3/8 + random(size/2 - size*3/8 + 1);
+				if (random(2)) distance = size - distance;
+			}
+			exit = (entry + distance) % size;
+			if (exit % (2*layer + 1) != 0) break;
+		}
+		if (exit % (2*layer + 1) == 0) {
+			exit = (exit + 1) % size;
+			distance = (distance + 1) % size;
+		}
+
+		//近い方の道を出口の直前で塞ぐ
+		//一番外側はスタートの東の壁がその役目
+		if (layer == N/2-1) {
+			setWall(IndexVec(0,0), 1, true);
+		}
+		else {
+			const int blocked = (distance <= size/2) ? (exit + size - 1) % size : (exit + 1) % size;
+			const IndexVec cur = ringIndex(layer, exit);
+			const IndexVec dxdy = ringIndex(layer, blocked) - cur;
+			for (int dir=0;dir<4;dir++) {
+				if (dxdy == IndexVec::vecDir[dir]) setWall(cur, dir, true);
+			}
+		}
+
+		//出口から内側の輪へ
+		//辺の番号が0(西),1(北),2(東),3(南)のとき、内側は東,南,西,北
+		const int inward = (exit / (2*layer + 1) + 1) % 4;
+		const IndexVec exitIndex = ringIndex(layer, exit);
+		setWall(exitIndex, inward, false);
+
+		const IndexVec next = exitIndex + IndexVec::vecDir[inward];
+		if (layer > 1) {
+			for (int i=0;i<ringSize(layer-1);i++) {
+				if (ringIndex(layer-1, i) == next) {
+					entry = i;
+					break;
+				}
+			}
+		}
+	}
+}
+
+template<int N>
+void MazeGeneratorT<N>::generate(MazeT<N> &maze, Type type)
+{
+	switch (type) {
+	case PERFECT:
+		generatePerfect();
+		break;
+	case LOOPY:
+		generatePerfect();
+		addLoop(N*N/10, 2 + random(2));
+		break;
+	case DIAGONAL:
+		generatePerfect();
+		addDiagonal(N);
+		break;
+	case ADVERSARIAL:
+		generateAdversarial();
+		break;
+	}
+
+	maze.clear();
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			maze.updateWall(IndexVec(x,y), Direction(wall[y][x]), true);
+		}
+	}
+}
+
+template<int N>
+const char *MazeGeneratorT<N>::typeName(Type type)
+{
+	switch (type) {
+	case PERFECT: return "perfect";
+	case LOOPY: return "loopy";
+	case DIAGONAL: return "diagonal";
+	default: return "adversarial";
+	}
+}
+
+template<int N>
+bool MazeGeneratorT<N>::typeFromName(const char *name, Type &type)
+{
+	const Type types[] = { PERFECT, LOOPY, DIAGONAL, ADVERSARIAL };
+	for (Type t : types) {
+		if (std::strcmp(name, typeName(t)) == 0) {
+			type = t;
+			return true;
+		}
+	}
+	return false;
+}
+
+//使う大きさの迷路の実体をつくる
+//16x16(クラシック)と32x32(ハーフサイズ)
+template class MazeGeneratorT<16>;
+template class MazeGeneratorT<32>;
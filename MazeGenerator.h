@@ -0,0 +1,80 @@
+#ifndef MAZEGENERATOR_H_
+#define MAZEGENERATOR_H_
+
+#include <cstdint>
+#include "MazeSolver_conf.h"
+#include "Maze.h"
+
+
+/**************************************************************
+ * MazeGeneratorT
+ *	シードから迷路を生成する
+ *	同じシード、同じ種類なら同じ迷路ができる(乱数は自前のxorshiftなので環境によらない)
+ *	どの種類もスタート(0,0)は東が壁で北に進め、ゴールは中央の2x2区画(中の壁はない)になる
+ *	N:迷路の大きさ
+ *
+ *	種類(Type)
+ *	PERFECT:ループのない迷路(穴掘り法) ゴールの入り口は1つ
+ *	LOOPY:PERFECTの壁をいくつか取り除いてループを作った迷路 ゴールの入り口が2,3個ある大会っぽい迷路
+ *	DIAGONAL:PERFECTに階段状の通路をいくつも掘った、斜め走行が長くなる迷路
+ *	ADVERSARIAL:ゴールのまわりを何重もの輪の通路が囲み、輪の切れ目が互い違いになっている迷路
+ *	  足立法は内側に進もうとして近い方から回り込むが、近い方は切れ目の直前で塞がっているので引き返すことになる
+ *
+ *	使い方
+ *	MazeGenerator generator(seed);
+ *	generator.generate(maze, MazeGenerator::LOOPY);
+ **************************************************************/
+template<int N>
+class MazeGeneratorT {
+public:
+	typedef enum {
+		PERFECT,
+		LOOPY,
+		DIAGONAL,
+		ADVERSARIAL,
+	} Type;
+
+	MazeGeneratorT(uint64_t seed = 1) { setSeed(seed); }
+	void setSeed(uint64_t seed);
+
+	//typeの迷路を生成してmazeに入れる
+	//mazeの壁は全て探索済みになる
+	void generate(MazeT<N> &maze, Type type);
+
+	//名前と種類の変換 "perfect", "loopy", "diagonal", "adversarial"
+	//名前が違う場合はfalseを返す
+	static const char *typeName(Type type);
+	static bool typeFromName(const char *name, Type &type);
+
+private:
+	uint64_t state;
+	//生成中の壁情報 下位4bitだけを使う
+	uint8_t wall[N][N];
+
+	//[0,n)の乱数
+	uint32_t random(uint32_t n);
+
+	inline bool isGoal(const IndexVec &index) const
+	{
+		return (index.x == N/2-1 || index.x == N/2) && (index.y == N/2-1 || index.y == N/2);
+	}
+	//curからi方向の壁を取り除く、つける(隣の区画の壁も合わせる)
+	void setWall(const IndexVec &cur, int i, bool exist);
+	//スタートの東の壁とゴールの周りの壁は、ループや階段を作るときに取り除かない
+	bool isFixedWall(const IndexVec &cur, int i) const;
+
+	void generatePerfect();
+	void addLoop(int nRemove, int nGoalEntrance);
+	void addDiagonal(int nStair);
+	void generateAdversarial();
+
+	//ADVERSARIALで使う
+	//layer番目の輪(ゴールがlayer 0)のi番目の区画 南西の角を0として時計回り(最初は北向き)に並べる
+	IndexVec ringIndex(int layer, int i) const;
+	inline int ringSize(int layer) const { return 8*layer + 4; }
+};
+
+typedef MazeGeneratorT<MAZE_SIZE> MazeGenerator;
+
+
+#endif /* MAZEGENERATOR_H_ */
@@ -0,0 +1,144 @@
+#ifndef MAZEIMAGE_H_
+#define MAZEIMAGE_H_
+
+#include <cstdint>
+#include "MazeSolver_conf.h"
+
+
+/**************************************************************
+ * MazeImageT
+ *	コンパイル時に解釈し終わった迷路の壁情報
+ *	迷路ファイル(.dat)の中身を文字列のままparseMazeImageに渡すと、constexprで壁情報の表になる
+ *	マイコンの起動時に文字列を解釈しなくてよく、Maze::loadFromImageはコピーするだけ
+ *	N:迷路の大きさ
+ *
+ *	row[y].cell[x]はMaze.wall[y][x]と同じ並び(原点は左下)で、上位4bitの探索済みbitは全て立っている
+ *	16進数でない文字はcellが0(探索済みbitが立っていない)になる
+ *
+ *	文字列はMaze::saveToFileで保存したのと同じ形式でないといけない
+ *	"0\nN\nN\n"のあとに1行N区画、区画の間は空白1つ、行末は改行のN行
+ *	R"(の直後から迷路ファイルの中身をそのまま貼り付ける
+ *	形式や壁が正しいかはisValid()で確認できるので、static_assertしておく
+ *
+ *	使い方
+ *	constexpr MazeImageT<16> mazeData_maze = parseMazeImage<16>(R"(0
+ *	16
+ *	16
+ *	9 5 5 1 ...
+ *	...
+ *	)");
+ *	static_assert(mazeData_maze.isValid(), "mazeData_maze is broken");
+ *	maze.loadFromImage(mazeData_maze);
+ **************************************************************/
+template<int N>
+struct MazeImageT {
+	struct Row {
+		uint8_t cell[N];
+	};
+	Row row[N];
+	//ヘッダの大きさ、区画の間の空白と行末の改行が正しいか
+	bool formatValid;
+
+	constexpr uint8_t get(int x, int y) const { return row[y].cell[x]; }
+
+	//形式が正しく、全ての区画が16進数で、外周に壁があり、隣り合う区画で壁が食い違っていないか
+	constexpr bool isValid() const { return formatValid && rowsValid(0); }
+
+private:
+	constexpr bool cellValid(int x, int y) const
+	{
+		return (get(x,y) & 0xf0) == 0xf0
+				&& (y != N-1 || (get(x,y) & 0x01))
+				&& (x != N-1 || (get(x,y) & 0x02))
+				&& (y != 0 || (get(x,y) & 0x04))
+				&& (x != 0 || (get(x,y) & 0x08))
+				&& (y == N-1 || !(get(x,y) & 0x01) == !(get(x,y+1) & 0x04))
+				&& (x == N-1 || !(get(x,y) & 0x02) == !(get(x+1,y) & 0x08));
+	}
+	constexpr bool cellsValid(int x, int y) const { return x == N || (cellValid(x,y) && cellsValid(x+1,y)); }
+	constexpr bool rowsValid(int y) const { return y == N || (cellsValid(0,y) && rowsValid(y+1)); }
+};
+
+
+//constexprの中でパラメータパックを0..K-1に展開するための列
+template<int... I> struct MazeImageSequence {};
+template<int K, int... I> struct MakeMazeImageSequence : MakeMazeImageSequence<K-1, K-1, I...> {};
+template<int... I> struct MakeMazeImageSequence<0, I...> { typedef MazeImageSequence<I...> type; };
+
+namespace mazeimage {
+
+constexpr uint8_t cellByte(char ch)
+{
+	return ('0' <= ch && ch <= '9') ? 0xf0 | (ch - '0')
+			: ('a' <= ch && ch <= 'f') ? 0xf0 | (ch - 'a' + 10)
+			: ('A' <= ch && ch <= 'F') ? 0xf0 | (ch - 'A' + 10)
+			: 0x00;
+}
+
+//posから10進数を読む
+constexpr int readInt(const char *text, int pos, int value)
+{
+	return ('0' <= text[pos] && text[pos] <= '9') ? readInt(text, pos+1, value*10 + (text[pos] - '0')) : value;
+}
+
+//posからnLine行読み飛ばした位置
+constexpr int skipLine(const char *text, int pos, int nLine)
+{
+	return nLine == 0 ? pos : text[pos] == '\0' ? pos : skipLine(text, pos+1, text[pos] == '\n' ? nLine-1 : nLine);
+}
+
+//1行の区画の間が空白、行末が改行になっているか
+template<int N>
+constexpr bool rowFormatValid(const char *text, int pos, int x)
+{
+	return x == N || (cellByte(text[pos + 2*x]) != 0 && text[pos + 2*x + 1] == (x == N-1 ? '\n' : ' ') && rowFormatValid<N>(text, pos, x+1));
+}
+template<int N>
+constexpr bool rowsFormatValid(const char *text, int body, int i)
+{
+	return i == N || (rowFormatValid<N>(text, body + i*2*N, 0) && rowsFormatValid<N>(text, body, i+1));
+}
+
+//ヘッダが"0\nN\nN\n"、その後にN行、最後は改行か文字列の終わり
+template<int N>
+constexpr bool formatValid(const char *text, int body)
+{
+	return readInt(text, skipLine(text, 0, 1), 0) == N && readInt(text, skipLine(text, 0, 2), 0) == N
+			&& rowsFormatValid<N>(text, body, 0)
+			&& (text[body + N*2*N] == '\0' || text[body + N*2*N] == '\n');
+}
+
+//ファイルのi行目(上から)がMaze.wallのN-1-i行目
+template<int N, int... X>
+constexpr typename MazeImageT<N>::Row decodeRow(const char *text, int pos, MazeImageSequence<X...>)
+{
+	return { { cellByte(text[pos + 2*X])... } };
+}
+template<int N, int... Y>
+constexpr MazeImageT<N> decode(const char *text, int body, bool valid, MazeImageSequence<Y...>)
+{
+	return { { decodeRow<N>(text, body + (N-1-Y)*2*N, typename MakeMazeImageSequence<N>::type())... }, valid };
+}
+
+template<int N>
+constexpr MazeImageT<N> parse(const char *text, int body)
+{
+	//形式が違う場合は、文字列の外を読まないように区画を読まない
+	return formatValid<N>(text, body)
+			? decode<N>(text, body, true, typename MakeMazeImageSequence<N>::type())
+			: MazeImageT<N>{ {}, false };
+}
+
+}
+
+//迷路ファイルの中身からMazeImageTをつくる
+template<int N>
+constexpr MazeImageT<N> parseMazeImage(const char *text)
+{
+	return mazeimage::parse<N>(text, mazeimage::skipLine(text, 0, 3));
+}
+
+typedef MazeImageT<MAZE_SIZE> MazeImage;
+
+
+#endif /* MAZEIMAGE_H_ */
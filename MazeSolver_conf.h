@@ -12,6 +12,32 @@
 //4個でなくてもよい
 #define MAZE_GOAL_LIST { IndexVec(7,7), IndexVec(7,8), IndexVec(8,7), IndexVec(8,8) }
 
+//歩数マップの差分更新で覚えておく、壁情報が変化した座標の最大数
+//前回の計算からこれより多くの座標の壁が更新された場合は歩数マップを全て計算しなおす
+#define STEPMAP_REPAIR_BUFFER_SIZE 16
+
+//歩数マップのキャッシュの数
+//目標座標(の集合)とonlyUseFoundWallごとに計算した歩数マップを覚えておき、壁情報が変わるまでは計算しなおさない
+//いっぱいになったら一番長く使っていないものを捨てる
+//Mazeのサイズが1つあたりN*N*sizeof(Step)byte(16x16なら256byte、32x32なら2KB)と少し大きくなる
+//0にするとキャッシュしない
+#ifndef STEPMAP_CACHE_SIZE
+#define STEPMAP_CACHE_SIZE 	2
+#endif
+
+//歩数マップを全て計算しなおすときの方法
+//STEPMAP_QUEUE:queueを使った幅優先探索で1区画ずつ広げる
+//STEPMAP_BITBOARD:壁情報をBitBoardでも持っておき、1歩分を全区画まとめてbit演算で広げる
+//  Mazeのサイズが方角ごとのBitBoard8枚分(16x16なら256byte)大きくなる
+//STEPMAP_SIMD:歩数マップの1行をSIMDレジスタに入れ、行ごとに隣の区画からの歩数で緩和するのを変化がなくなるまで繰り返す
+//  16x16はSSE2、32x32はAVX2を使う。使えない場合は同じ計算を普通のループで行う
+#define STEPMAP_QUEUE 		0
+#define STEPMAP_BITBOARD 	1
+#define STEPMAP_SIMD 		2
+#ifndef MAZE_STEPMAP_METHOD
+#define MAZE_STEPMAP_METHOD STEPMAP_QUEUE
+#endif
+
 
 /****************************************
  * 探索アルゴリズムに関するパラメータ
@@ -19,17 +45,101 @@
 //一旦ゴールに到達したあとのk最短経路を計算するときのk
 #define SEARCH_DEPTH1 1
 
+//一旦ゴールに到達したあと、追加で探索する座標の選び方
+//SEARCH_BY_DISTANCE:SEARCH_DEPTH1個の(歩数の)k最短経路の上で、未探索の壁がある座標
+//SEARCH_BY_TIME:未探索の壁ごとに、その壁を通る経路の走行時間の最小値(ほかの未探索の壁は通れるものとする)を計算し、
+//  今わかっている壁だけで走れる経路の走行時間よりSEARCH_TIME_THRESHOLD以上短くなる壁のうち、
+//  未探索の壁を全て通れるとしたときの最短の走行時間からSEARCH_TIME_MARGIN以内の経路が通る壁がある座標
+//  そのような壁がなくなったら探索をやめる
+//  走行時間はAgent::setSearchProfileで渡した走行性能で見積もる
+#define SEARCH_BY_DISTANCE 	0
+#define SEARCH_BY_TIME 		1
+#ifndef AGENT_SEARCH_TARGET
+#define AGENT_SEARCH_TARGET SEARCH_BY_DISTANCE
+#endif
+
+//SEARCH_BY_TIMEで、これ以上速くならないなら探索しなくてよいとする走行時間[s]
+#ifndef SEARCH_TIME_THRESHOLD
+#define SEARCH_TIME_THRESHOLD 	0.1
+#endif
+
+//SEARCH_BY_TIMEで、楽観的な最短の走行時間からどれだけ遅い経路の壁まで一度に探索するか[s]
+//大きくすると、探索すべき壁を全て一度に候補にする(遠くの壁にも向かうので探索の歩数が増え、計算も重くなる)
+#ifndef SEARCH_TIME_MARGIN
+#define SEARCH_TIME_MARGIN 	0.0
+#endif
+
 //探索が終了し、最終的な走行ルートを計算するときのk
 #define SEARCH_DEPTH2 20
 
+//k最短経路の計算でspur nodeごとの経路を並列に計算するときのスレッド数
+//1の場合はスレッドを使わない。2以上にする場合はstd::threadが使える環境でビルドする(gccなら-pthread)
+//スレッド数によらず、計算結果は同じになる
+#ifndef KSHORTEST_PATH_THREADS
+#define KSHORTEST_PATH_THREADS 1
+#endif
+
+//最終的な走行ルートを計算する方法
+//RUN_SEQUENCE_K_SHORTEST:SEARCH_DEPTH2個のk最短経路のうち、走行時間が一番短いものを選ぶ
+//RUN_SEQUENCE_STATE_GRAPH:区画、向き、直前の曲がり方を状態としたグラフの上で、走行時間が最短の経路を直接探す
+//  k最短経路に入っていない経路も調べるので、同じか短い時間の経路が見つかる
+#define RUN_SEQUENCE_K_SHORTEST 	0
+#define RUN_SEQUENCE_STATE_GRAPH 	1
+#ifndef RUN_SEQUENCE_METHOD
+#define RUN_SEQUENCE_METHOD RUN_SEQUENCE_STATE_GRAPH
+#endif
+
 
 //経路のコストを計算するときに使うロボットの走行性能
+//RobotProfileのデフォルト値 実行時に変える場合はRobotProfileをつくって渡す
 //90度曲がるブロックを進むのにかかる時間[s]
 #define TURN90_TIME 	0.3
 
 //45度曲がるブロックを進むのにかかる時間[s]
 #define TURN45_TIME 	0.2
 
+//一旦ゴールに到達したあと、追加で探索する座標をどの順番で回るか
+//1:SearchTourで全ての座標を回る歩数が短くなる順番を計算し、その順番に向かう
+//  暫定最短経路の上に壁が見つかるまではk最短経路を計算しなおさず、探索し終わった座標を順番から除いていく
+//  壁が増えて次の座標までの歩数が伸びたら、今の座標から順番を改善しなおす
+//  区画の組の歩数をDistanceOracleで覚えておくので、16x16で64KB、32x32で2MBのメモリを使う
+//0:毎回一番近い座標に向かう(デフォルト)
+//  maze_dataの迷路では1にすると探索で走る区画数が増え(2664->2750)、計算時間も大きく増えるので、0にしておく
+#ifndef AGENT_USE_SEARCH_TOUR
+#define AGENT_USE_SEARCH_TOUR 	0
+#endif
+
+//AgentがDistanceOracle(区画の組の歩数の表)を持つか
+//表を使って目標座標を選ぶもの(AGENT_USE_SEARCH_TOUR)を使うときだけ1になる
+#ifndef AGENT_USE_DISTANCE_ORACLE
+#define AGENT_USE_DISTANCE_ORACLE 	AGENT_USE_SEARCH_TOUR
+#endif
+#if AGENT_USE_SEARCH_TOUR && !AGENT_USE_DISTANCE_ORACLE
+#error "AGENT_USE_SEARCH_TOUR needs AGENT_USE_DISTANCE_ORACLE"
+#endif
+
+//SearchTourで順番を改善するときに評価する手の数の上限
+//手1つはDistanceOracleの表を4〜6回引くだけ
+#ifndef AGENT_SEARCH_TOUR_BUDGET
+#define AGENT_SEARCH_TOUR_BUDGET 	4096
+#endif
+
+//大回りのターンにかかる時間[s]
+//大回り90度(前後の直線1区画ずつを含む)
+#define TURN90_LARGE_TIME 	0.4
+//180度(前後の直線1区画ずつを含む)
+#define TURN180_TIME 	0.55
+//135度(90度ターンと45度ターンの分)
+#define TURN135_TIME 	0.4
+//V90度(45度ターン2回の分)
+#define TURNV90_TIME 	0.3
+
+//大回りのターンを使って最終的な経路を計算するか
+//走行側が大回りのターンに対応していない場合は0にする
+#ifndef USE_LARGE_TURN
+#define USE_LARGE_TURN 	0
+#endif
+
 //加速度[m/s^2]
 #define ACCELERATION 	6.0
 
@@ -43,4 +153,23 @@
 #define MAZE_1BLOCK_LENGTH 	0.18
 
 
+/****************************************
+ * 計測に関するパラメータ
+ ****************************************/
+//1にすると、Agent::update(全体とAgentの状態ごと)、Maze::updateStepMap、ShortestPath::calcKShortestDistancePath、
+//Agent::caclRunSequenceの呼び出し回数、最悪時間、時間のヒストグラムを記録する(Profiler.h)
+//0のときは計測のコードは何も入らない
+#ifndef MAZESOLVER_PROFILE
+#define MAZESOLVER_PROFILE 	0
+#endif
+
+//計測に使う時計
+//PROFILE_CLOCK():今の時刻[tick]を符号なし整数で返す式(1回の呼び出しより長い周期なら途中で1周してもよい)
+//PROFILE_CLOCK_HZ:1秒あたりのtick数
+//定義しなければstd::chrono::steady_clockをns単位で使う
+//例:Cortex-MのDWTサイクルカウンタ
+//#define PROFILE_CLOCK() 	(DWT->CYCCNT)
+//#define PROFILE_CLOCK_HZ 	168000000
+
+
 #endif /* MAZESOLVER_CONF_H_ */
@@ -1,31 +1,191 @@
 #include <cmath>
+#include <algorithm>
 #include <cstdio>
 #include "Operation.h"
 
+OperationCostTable::OperationCostTable(double turn90Time, double turn45Time,
+		double acceleration, double maxVelocity, double minVelocity, double blockLength)
+{
+	for (int i=0;i<=Operation::STOP;i++) turn[i] = 0.0;
+	setTurnTime(Operation::TURN_RIGHT90, turn90Time);
+	setTurnTime(Operation::TURN_RIGHT45, turn45Time);
+	setTurnTime(Operation::TURN_RIGHT90_LARGE, TURN90_LARGE_TIME);
+	setTurnTime(Operation::TURN_RIGHT180, TURN180_TIME);
+	setTurnTime(Operation::TURN_RIGHT135_IN, TURN135_TIME);
+	setTurnTime(Operation::TURN_RIGHT135_OUT, TURN135_TIME);
+	setTurnTime(Operation::TURN_RIGHTV90, TURNV90_TIME);
+
+	//「直線は速度が台形になるように加速する」と仮定してコストを計算
+	const float accelDistance = (maxVelocity*maxVelocity - minVelocity*minVelocity) / (2*acceleration);
+	auto straightTime = [&](float distance) -> float {
+		if (distance > 2*accelDistance) {
+			return (distance - 2*accelDistance)/maxVelocity + 2*( (maxVelocity-minVelocity)/acceleration);
+		}
+		else {
+			const float rt = std::sqrt(minVelocity*minVelocity + 2*acceleration*distance/2);
+			return 2*( (-minVelocity + rt)/acceleration );
+		}
+	};
+
+	forward[0] = forwardDiag[0] = 0.0;
+	for (int n=1;n<=UINT8_MAX;n++) {
+		forward[n] = straightTime((float)n * blockLength);
+		forwardDiag[n] = straightTime((float)n * blockLength / 2.0 * M_SQRT2);
+	}
+}
+
+void OperationCostTable::setTurnTime(Operation::OperationType op, double time)
+{
+	if (!Operation(op).isTurn()) return;
+	turn[op] = turn[Operation::mirror(op)] = time;
+}
+
+const OperationCostTable &OperationCostTable::getDefault()
+{
+	return RobotProfile::getDefault().getCostTable();
+}
+
+const RobotProfile &RobotProfile::getDefault()
+{
+	static const RobotProfile profile;
+	return profile;
+}
+
+void RobotProfile::setTurnVelocity(Operation::OperationType turn, double entryVelocity, double exitVelocity)
+{
+	if (!Operation(turn).isTurn()) return;
+	const Operation::OperationType mirror = Operation::mirror(turn);
+	turnEntryVelocity[turn] = turnEntryVelocity[mirror] = entryVelocity;
+	turnExitVelocity[turn] = turnExitVelocity[mirror] = exitVelocity;
+	velocityModel = true;
+}
+
+bool Operation::isRightTurn() const
+{
+	switch (op) {
+	case TURN_RIGHT90:
+	case TURN_RIGHT45:
+	case TURN_RIGHT90_LARGE:
+	case TURN_RIGHT180:
+	case TURN_RIGHT135_IN:
+	case TURN_RIGHT135_OUT:
+	case TURN_RIGHTV90:
+		return true;
+	default:
+		return false;
+	}
+}
+
+Operation::OperationType Operation::mirror(OperationType op)
+{
+	switch (op) {
+	case TURN_RIGHT90: return TURN_LEFT90;
+	case TURN_LEFT90: return TURN_RIGHT90;
+	case TURN_RIGHT45: return TURN_LEFT45;
+	case TURN_LEFT45: return TURN_RIGHT45;
+	case TURN_RIGHT90_LARGE: return TURN_LEFT90_LARGE;
+	case TURN_LEFT90_LARGE: return TURN_RIGHT90_LARGE;
+	case TURN_RIGHT180: return TURN_LEFT180;
+	case TURN_LEFT180: return TURN_RIGHT180;
+	case TURN_RIGHT135_IN: return TURN_LEFT135_IN;
+	case TURN_LEFT135_IN: return TURN_RIGHT135_IN;
+	case TURN_RIGHT135_OUT: return TURN_LEFT135_OUT;
+	case TURN_LEFT135_OUT: return TURN_RIGHT135_OUT;
+	case TURN_RIGHTV90: return TURN_LEFTV90;
+	case TURN_LEFTV90: return TURN_RIGHTV90;
+	default: return op;
+	}
+}
+
+float Operation::eval() const
+{
+	return OperationCostTable::getDefault().eval(*this);
+}
+
 float OperationList::eval() const
+{
+	return eval(OperationCostTable::getDefault());
+}
+
+float OperationList::eval(const OperationCostTable &table) const
 {
 	float cost = 0.0;
 	for (auto &operation : opList) {
-		if (operation.op == Operation::FORWARD || operation.op == Operation::FORWARD_DIAG) {
-			//「直線は速度が台形になるように加速する」と仮定してコストを計算
-			float distance;
-			if (operation.op == Operation::FORWARD_DIAG) distance = (float)operation.n * MAZE_1BLOCK_LENGTH / 2.0 * M_SQRT2;
-			else distance = (float)operation.n * MAZE_1BLOCK_LENGTH;
-			const float accelDistance = (MAX_VELOCITY*MAX_VELOCITY - MIN_VELOCITY*MIN_VELOCITY) / (2*ACCELERATION);
-
-			if (distance > 2*accelDistance) {
-				cost += (distance - 2*accelDistance)/MAX_VELOCITY + 2*( (MAX_VELOCITY-MIN_VELOCITY)/ACCELERATION);
-			}
-			else {
-				const float rt = std::sqrt(MIN_VELOCITY*MIN_VELOCITY + 2*ACCELERATION*distance/2);
-				cost += 2*( (-MIN_VELOCITY + rt)/ACCELERATION );
-			}
+		cost += table.eval(operation);
+	}
+
+	return cost;
+}
+
+
+float OperationList::evalWithVelocity(const RobotProfile &profile) const
+{
+	const float a = profile.getAcceleration();
+	const float maxVelocity = profile.getMaxVelocity();
+	const float minVelocity = profile.getMinVelocity();
+	auto distance = [&](const Operation &operation) -> float {
+		if (operation.op == Operation::FORWARD_DIAG) return (float)operation.n * profile.getBlockLength() / 2.0 * M_SQRT2;
+		return (float)operation.n * profile.getBlockLength();
+	};
+
+	//boundaryVelocity[i]はi番目の動作の入口(i-1番目の出口)の速度
+	//ターンの入口、出口の速度とスタート、ゴールの速度で上限を決める
+	const size_t n = opList.size();
+	std::vector<float> &v = boundaryVelocity;
+	v.assign(n+1, maxVelocity);
+	v[0] = v[n] = minVelocity;
+	for (size_t i=0;i<n;i++) {
+		if (!opList[i].isTurn()) continue;
+		v[i] = std::min(v[i], profile.getTurnEntryVelocity(opList[i].op));
+		v[i+1] = std::min(v[i+1], profile.getTurnExitVelocity(opList[i].op));
+	}
+
+	//前から 加速が間に合う速度まで下げる
+	//ターンは入口と出口の速度の比を保つ
+	for (size_t i=0;i<n;i++) {
+		const Operation &operation = opList[i];
+		if (operation.isStraight()) {
+			v[i+1] = std::min(v[i+1], std::sqrt(v[i]*v[i] + 2*a*distance(operation)));
 		}
-		else if (operation.op == Operation::TURN_LEFT90 || operation.op == Operation::TURN_RIGHT90) {
-			cost += TURN90_TIME;
+		else if (operation.isTurn()) {
+			const float ratio = profile.getTurnExitVelocity(operation.op) / profile.getTurnEntryVelocity(operation.op);
+			v[i+1] = std::min(v[i+1], v[i]*ratio);
 		}
-		else if (operation.op == Operation::TURN_LEFT45 || operation.op == Operation::TURN_RIGHT45) {
-			cost += TURN45_TIME;
+		else {
+			v[i+1] = std::min(v[i+1], v[i]);
+		}
+	}
+	//後ろから 減速が間に合う速度まで下げる
+	for (size_t i=n;i>0;i--) {
+		const Operation &operation = opList[i-1];
+		if (operation.isStraight()) {
+			v[i-1] = std::min(v[i-1], std::sqrt(v[i]*v[i] + 2*a*distance(operation)));
+		}
+		else if (operation.isTurn()) {
+			const float ratio = profile.getTurnEntryVelocity(operation.op) / profile.getTurnExitVelocity(operation.op);
+			v[i-1] = std::min(v[i-1], v[i]*ratio);
+		}
+		else {
+			v[i-1] = std::min(v[i-1], v[i]);
+		}
+	}
+
+	const OperationCostTable &table = profile.getCostTable();
+	float cost = 0.0;
+	for (size_t i=0;i<n;i++) {
+		const Operation &operation = opList[i];
+		const float v0 = v[i], v1 = v[i+1];
+		if (operation.isStraight()) {
+			//v0から最高速度(届かなければ途中の速度)まで加速してv1まで減速する
+			const float d = distance(operation);
+			const float peak = std::min(maxVelocity, std::sqrt((2*a*d + v0*v0 + v1*v1) / 2));
+			const float accelDistance = (2*peak*peak - v0*v0 - v1*v1) / (2*a);
+			cost += (peak - v0)/a + (peak - v1)/a + std::max(0.0f, d - accelDistance)/peak;
+		}
+		else if (operation.isTurn()) {
+			//決まった時間は入口、出口の速度で曲がったとき
+			const float nominal = profile.getTurnEntryVelocity(operation.op) + profile.getTurnExitVelocity(operation.op);
+			cost += (v0 + v1 > 0) ? table.eval(operation) * nominal / (v0 + v1) : table.eval(operation);
 		}
 	}
 
@@ -33,125 +193,215 @@ float OperationList::eval() const
 }
 
 
-void OperationList::loadFromPath(const Path& path, bool useDiagonalPath)
+void RobotProfileSet::add(const RobotProfile &profile)
+{
+	const size_t nProfile = profiles.size();
+	const OperationCostTable &table = profile.getCostTable();
+
+	//各行の最後に新しいprofileの値を差し込む
+	auto insertColumn = [&](std::vector<float> &column, const std::vector<float> &value) {
+		std::vector<float> newColumn(value.size()*(nProfile+1));
+		for (size_t n=0;n<value.size();n++) {
+			for (size_t i=0;i<nProfile;i++) newColumn[n*(nProfile+1) + i] = column[n*nProfile + i];
+			newColumn[n*(nProfile+1) + nProfile] = value[n];
+		}
+		column.swap(newColumn);
+	};
+	std::vector<float> value(UINT8_MAX+1);
+	for (int n=0;n<=UINT8_MAX;n++) value[n] = table.getForward(n);
+	insertColumn(forward, value);
+	for (int n=0;n<=UINT8_MAX;n++) value[n] = table.getForwardDiag(n);
+	insertColumn(forwardDiag, value);
+	value.resize(Operation::STOP+1);
+	for (int op=0;op<=Operation::STOP;op++) value[op] = table.getTurn((Operation::OperationType)op);
+	insertColumn(turn, value);
+
+	profiles.push_back(profile);
+}
+
+void RobotProfileSet::clear()
 {
-	opList.clear();
-	std::vector<Operation> tmp_opList;
+	profiles.clear();
+	forward.clear();
+	forwardDiag.clear();
+	turn.clear();
+}
+
+void RobotProfileSet::eval(const OperationList &opList, float *cost) const
+{
+	const size_t nProfile = profiles.size();
+	for (size_t i=0;i<nProfile;i++) cost[i] = 0.0;
+
+	for (auto &operation : opList) {
+		const float *row;
+		switch (operation.op) {
+		case Operation::FORWARD: row = &forward[operation.n*nProfile]; break;
+		case Operation::FORWARD_DIAG: row = &forwardDiag[operation.n*nProfile]; break;
+		default: row = &turn[operation.op*nProfile]; break;
+		}
+		for (size_t i=0;i<nProfile;i++) cost[i] += row[i];
+	}
+}
+
+
+template<size_t CAPACITY>
+OperationList::PathError OperationList::compilePath(const FixedVector<IndexVec, CAPACITY>& path, bool useDiagonalPath,
+		Operation *buffer, size_t capacity, size_t &nOp)
+{
+	nOp = 0;
+
+	//まだ書いていない直進の区画数
+	int nForward = 0;
+	//まだ書いていない左右交互の連続ターン 最初と最後のターンと、ターンの数
+	Operation::OperationType runFirst = Operation::STOP;
+	Operation::OperationType runLast = Operation::STOP;
+	int runLength = 0;
+
+	auto emit = [&](const Operation &operation) {
+		if (nOp >= capacity) return false;
+		buffer[nOp++] = operation;
+		return true;
+	};
+	auto flushForward = [&]() {
+		if (nForward == 0) return true;
+		const bool ok = emit(Operation(Operation::FORWARD, nForward));
+		nForward = 0;
+		return ok;
+	};
+	//ターン1回はそのまま、2回以上は最初に曲がった方向に45度、斜め直進、最後に曲がった方向に45度
+	auto flushRun = [&]() {
+		bool ok = true;
+		if (runLength == 1) {
+			ok = emit(Operation(runFirst));
+		}
+		else if (runLength > 1) {
+			ok = emit(Operation(runFirst == Operation::TURN_RIGHT90 ? Operation::TURN_RIGHT45 : Operation::TURN_LEFT45));
+			if (ok && runLength > 2) ok = emit(Operation(Operation::FORWARD_DIAG, runLength-2));
+			if (ok) ok = emit(Operation(runLast == Operation::TURN_RIGHT90 ? Operation::TURN_RIGHT45 : Operation::TURN_LEFT45));
+		}
+		runLength = 0;
+		return ok;
+	};
 
 	int8_t robotDir = 0;
-	for (size_t i=0;i<path.size()-1; i++) {
+	for (size_t i=0;i+1<path.size();i++) {
 		const IndexVec dxdy = path[i+1] - path[i];
-		int8_t dir = 0;
+		int8_t dir = -1;
 		for (int j=0;j<4;j++) {
-			if (dxdy == IndexVec::vecDir[j]) {
-				dir = j;
-			}
+			if (dxdy == IndexVec::vecDir[j]) dir = j;
 		}
+		if (dir < 0) return PATH_NOT_ADJACENT;
 
-		const int8_t dirDiff = dir - robotDir;
+		const int8_t dirDiff = (dir - robotDir + 4) % 4;
+		robotDir = dir;
 		if (dirDiff == 0) {
-			tmp_opList.push_back(Operation(Operation::FORWARD));
+			if (!flushRun()) return PATH_BUFFER_FULL;
+			nForward++;
+			continue;
 		}
-		else if (dirDiff == 1 || dirDiff == -3) {
-			tmp_opList.push_back(Operation(Operation::TURN_RIGHT90));
+		if (dirDiff == 2) return PATH_U_TURN;
+
+		const Operation::OperationType turn = (dirDiff == 1) ? Operation::TURN_RIGHT90 : Operation::TURN_LEFT90;
+		if (!flushForward()) return PATH_BUFFER_FULL;
+		if (!useDiagonalPath) {
+			if (!emit(Operation(turn))) return PATH_BUFFER_FULL;
 		}
-		else if (dirDiff == -1 || dirDiff == 3) {
-			tmp_opList.push_back(Operation(Operation::TURN_LEFT90));
+		//前のターンと逆向きなら斜め区間が続く
+		else if (runLength > 0 && turn != runLast) {
+			runLast = turn;
+			runLength++;
 		}
-		//おかしい
 		else {
-			while(1);
+			if (!flushRun()) return PATH_BUFFER_FULL;
+			runFirst = runLast = turn;
+			runLength = 1;
 		}
-		robotDir = dir;
 	}
-	opList = tmp_opList;
-	tmp_opList.clear();
-
-	//ななめ走行ありのありの場合の計算
-	if (useDiagonalPath) {
-		Operation currentDiagOp;
-		for (size_t i=0;i<opList.size();i++) {
-			if (opList[i].op == Operation::TURN_RIGHT90 || opList[i].op == Operation::TURN_LEFT90) {
-				Operation::OperationType prevDiagOp = opList[i].op;
-
-				//jは斜め区間の終わりを指す
-				size_t j = i;
-				//この後ろの部分でjを斜め区間のおわりまで進めていく
-				//TODO:もっとエレガントにしたい
-				while(1) {
-					j++;
-					if (prevDiagOp == Operation::TURN_RIGHT90) {
-						if (opList[j].op != Operation::TURN_LEFT90) {
-							break;
-						}
-						else {
-							prevDiagOp = opList[j].op;
-						}
-					}
-					else if (prevDiagOp == Operation::TURN_LEFT90) {
-						if (opList[j].op != Operation::TURN_RIGHT90) {
-							break;
-						}
-						else {
-							prevDiagOp = opList[j].op;
-						}
-					}
-				}
-
-				if (j-i > 1) {
-					//RLRL
-					//斜め区間の入る方向と出る方向が同じ時
-					if ((j-i)%2 == 0) {
-						if (prevDiagOp == Operation::TURN_RIGHT90) tmp_opList.push_back(Operation(Operation::TURN_LEFT45));
-						else tmp_opList.push_back(Operation(Operation::TURN_RIGHT45));
-						if (j-i-2>0) {
-							tmp_opList.push_back(Operation(Operation::FORWARD_DIAG,j-i-2));
-						}
-						if (prevDiagOp == Operation::TURN_RIGHT90) tmp_opList.push_back(Operation(Operation::TURN_RIGHT45));
-						else tmp_opList.push_back(Operation(Operation::TURN_LEFT45));
-					}
-					//RLR
-					//斜め区間の入る方向と出る方向が違う時
-					else {
-						if (prevDiagOp == Operation::TURN_RIGHT90) tmp_opList.push_back(Operation(Operation::TURN_RIGHT45));
-						else tmp_opList.push_back(Operation(Operation::TURN_LEFT45));
-						tmp_opList.push_back(Operation(Operation::FORWARD_DIAG,j-i-2));
-
-						if (prevDiagOp == Operation::TURN_RIGHT90) tmp_opList.push_back(Operation(Operation::TURN_RIGHT45));
-						else tmp_opList.push_back(Operation(Operation::TURN_LEFT45));
-					}
-					i = j - 1;
-				}
-				else {
-					tmp_opList.push_back(opList[i]);
-				}
+	if (!flushRun() || !flushForward()) return PATH_BUFFER_FULL;
 
-			}
-			else {
-				tmp_opList.push_back(opList[i]);
-			}
-		}
+	return PATH_OK;
+}
 
-		opList.clear();
-		opList = tmp_opList;
-	}
+template<size_t CAPACITY>
+OperationList::PathError OperationList::loadFromPath(const FixedVector<IndexVec, CAPACITY>& path, bool useDiagonalPath)
+{
+	//動作の数は区画を進む回数を超えない
+	opList.resize(path.size() < 2 ? 0 : path.size()-1);
+	size_t nOp = 0;
+	const PathError error = compilePath(path, useDiagonalPath, opList.data(), opList.size(), nOp);
+	opList.resize(error == PATH_OK ? nOp : 0);
+	return error;
+}
+
+void OperationList::convertToLargeTurn()
+{
+	//変換後の動作の数は変換前より増えないので、opListの前から詰めて書いていく
+	//前後の直線を1区画ずつ使う場合は、書き終わった直前の直線と、まだ読んでいない直後の直線を短くする
+	auto is90 = [](const Operation &operation) { return operation.op == Operation::TURN_RIGHT90 || operation.op == Operation::TURN_LEFT90; };
+	auto is45 = [](const Operation &operation) { return operation.op == Operation::TURN_RIGHT45 || operation.op == Operation::TURN_LEFT45; };
+	auto sameSide = [](const Operation &a, const Operation &b) { return a.isRightTurn() == b.isRightTurn(); };
+	auto turnOf = [](Operation::OperationType right, const Operation &operation) {
+		return Operation(operation.isRightTurn() ? right : Operation::mirror(right));
+	};
 
-	tmp_opList = opList;
-	opList.clear();
+	const size_t n = opList.size();
+	size_t nOp = 0;
+	for (size_t i=0;i<n;i++) {
+		const Operation &cur = opList[i];
+		const bool hasPrev = nOp > 0;
+		const bool hasNext = i+1 < n;
+		const bool forwardBefore = hasPrev && opList[nOp-1].op == Operation::FORWARD;
 
-	//FORWARDの圧縮
-	opList.push_back(tmp_opList[0]);
-	for (size_t i=1;i<tmp_opList.size();i++) {
-		if (tmp_opList[i].op == Operation::FORWARD && tmp_opList[i].op == opList.back().op) {
-			opList.back().n++;
+		if (is90(cur)) {
+			//180度
+			if (forwardBefore && i+2 < n && opList[i+1].op == cur.op && opList[i+2].op == Operation::FORWARD) {
+				if (--opList[nOp-1].n == 0) nOp--;
+				opList[nOp++] = turnOf(Operation::TURN_RIGHT180, cur);
+				if (--opList[i+2].n == 0) i += 2;
+				else i += 1;
+				continue;
+			}
+			//135度で斜めに入る
+			if (hasNext && is45(opList[i+1]) && sameSide(cur, opList[i+1])) {
+				opList[nOp++] = turnOf(Operation::TURN_RIGHT135_IN, cur);
+				i++;
+				continue;
+			}
+			//大回り90度
+			if (forwardBefore && hasNext && opList[i+1].op == Operation::FORWARD) {
+				if (--opList[nOp-1].n == 0) nOp--;
+				opList[nOp++] = turnOf(Operation::TURN_RIGHT90_LARGE, cur);
+				if (--opList[i+1].n == 0) i++;
+				continue;
+			}
 		}
-		else {
-			opList.push_back(tmp_opList[i]);
+		else if (is45(cur) && hasNext && sameSide(cur, opList[i+1])) {
+			//斜めの前後以外に45度ターンはないので、同じ向きの45度が並ぶのは出てすぐ入るところ
+			//135度で斜めから出る
+			if (is90(opList[i+1])) {
+				opList[nOp++] = turnOf(Operation::TURN_RIGHT135_OUT, cur);
+				i++;
+				continue;
+			}
+			//V90度
+			if (is45(opList[i+1])) {
+				opList[nOp++] = turnOf(Operation::TURN_RIGHTV90, cur);
+				i++;
+				continue;
+			}
 		}
-	}
 
+		opList[nOp++] = cur;
+	}
+	opList.resize(nOp);
 }
 
+//使う大きさの迷路の経路を読み込めるようにする
+template OperationList::PathError OperationList::compilePath(const PathT<16>& path, bool useDiagonalPath, Operation *buffer, size_t capacity, size_t &nOp);
+template OperationList::PathError OperationList::compilePath(const PathT<32>& path, bool useDiagonalPath, Operation *buffer, size_t capacity, size_t &nOp);
+template OperationList::PathError OperationList::loadFromPath(const PathT<16>& path, bool useDiagonalPath);
+template OperationList::PathError OperationList::loadFromPath(const PathT<32>& path, bool useDiagonalPath);
+
 
 void OperationList::print()
 {
@@ -162,7 +412,18 @@ void OperationList::print()
 		if (operation.op == Operation::TURN_RIGHT45) printf("r");
 		if (operation.op == Operation::TURN_LEFT45) printf("l");
 		if (operation.op == Operation::FORWARD_DIAG) printf("D");
-		printf("%d ",operation.n);
+		if (operation.op == Operation::TURN_RIGHT90_LARGE) printf("R90L");
+		if (operation.op == Operation::TURN_LEFT90_LARGE) printf("L90L");
+		if (operation.op == Operation::TURN_RIGHT180) printf("R180");
+		if (operation.op == Operation::TURN_LEFT180) printf("L180");
+		if (operation.op == Operation::TURN_RIGHT135_IN) printf("R135i");
+		if (operation.op == Operation::TURN_LEFT135_IN) printf("L135i");
+		if (operation.op == Operation::TURN_RIGHT135_OUT) printf("R135o");
+		if (operation.op == Operation::TURN_LEFT135_OUT) printf("L135o");
+		if (operation.op == Operation::TURN_RIGHTV90) printf("RV");
+		if (operation.op == Operation::TURN_LEFTV90) printf("LV");
+		//名前が数字で終わる動作があるので、回数との間に:を入れる
+		printf(":%d ",operation.n);
 	}
 	printf("\n");
 }
@@ -7,8 +7,6 @@
 #include "MazeSolver_conf.h"
 
 
-typedef std::vector<IndexVec> Path;
-
 /**************************************************************
  * Operation
  *	ロボットがすべき動作を表現
@@ -23,12 +21,144 @@ struct Operation {
 		TURN_RIGHT45,
 		TURN_LEFT90,
 		TURN_LEFT45,
+		//大回りのターン convertToLargeTurnで作る
+		TURN_RIGHT90_LARGE, 	//直線->直線 前後の直線の1区画ずつを使って大きく90度曲がる
+		TURN_LEFT90_LARGE,
+		TURN_RIGHT180, 		//直線->直線 前後の直線の1区画ずつを使って180度曲がる
+		TURN_LEFT180,
+		TURN_RIGHT135_IN, 	//直線->斜め 90度ターンと斜めに入る45度ターンをまとめたもの
+		TURN_LEFT135_IN,
+		TURN_RIGHT135_OUT, 	//斜め->直線 斜めから出る45度ターンと90度ターンをまとめたもの
+		TURN_LEFT135_OUT,
+		TURN_RIGHTV90, 		//斜め->斜め 斜めから出る45度ターンと斜めに入る45度ターンをまとめたもの
+		TURN_LEFTV90,
 		STOP,
 	} OperationType;
 
 	OperationType op;
 	uint8_t n;
 	Operation(OperationType _op = STOP, uint8_t _n = 1) : op(_op), n(_n) {}
+
+	inline bool isTurn() const { return op != FORWARD && op != FORWARD_DIAG && op != STOP; }
+	inline bool isStraight() const { return op == FORWARD || op == FORWARD_DIAG; }
+	bool isRightTurn() const;
+	//左右を入れ替えたターン ターン以外はそのまま
+	static OperationType mirror(OperationType op);
+
+	//この動作にかかるコスト(時間)を返す
+	//OperationCostTable::getDefault()の表を引く
+	float eval() const;
+};
+
+
+/**************************************************************
+ * OperationCostTable
+ *	Operationのコスト(時間)の表
+ *	直線、斜め直線は台形加速でかかる時間をn(uint8_t)ごとに先に全部計算しておき、
+ *	evalは表を引くだけにする(割り算もsqrtもしない)
+ *	getDefault()はRobotProfile::getDefault()(MazeSolver_conf.hの走行性能)の表
+ *	探索の内側のループで辺のコストを何度も計算する場合は、表を手元に持っておいて使う
+ **************************************************************/
+class OperationCostTable {
+private:
+	float forward[UINT8_MAX+1];
+	float forwardDiag[UINT8_MAX+1];
+	//ターンの時間 ターン以外は0
+	float turn[Operation::STOP+1];
+
+public:
+	//turn90Time, turn45Time:90度、45度曲がるブロックを進むのにかかる時間[s]
+	//acceleration[m/s^2], maxVelocity, minVelocity[m/s], blockLength:1区画の長さ[m]
+	//大回りのターンの時間はMazeSolver_conf.hの値(setTurnTimeで変えられる)
+	OperationCostTable(double turn90Time = TURN90_TIME, double turn45Time = TURN45_TIME,
+			double acceleration = ACCELERATION, double maxVelocity = MAX_VELOCITY, double minVelocity = MIN_VELOCITY,
+			double blockLength = MAZE_1BLOCK_LENGTH);
+
+	static const OperationCostTable &getDefault();
+
+	inline float getForward(uint8_t n) const { return forward[n]; }
+	inline float getForwardDiag(uint8_t n) const { return forwardDiag[n]; }
+	inline float getTurn90() const { return turn[Operation::TURN_RIGHT90]; }
+	inline float getTurn45() const { return turn[Operation::TURN_RIGHT45]; }
+	inline float getTurn(Operation::OperationType op) const { return turn[op]; }
+	//opのターンの時間[s]を変える 左右の両方に同じ値を使う
+	void setTurnTime(Operation::OperationType op, double time);
+
+	inline float eval(const Operation &operation) const
+	{
+		switch (operation.op) {
+		case Operation::FORWARD: return forward[operation.n];
+		case Operation::FORWARD_DIAG: return forwardDiag[operation.n];
+		default: return turn[operation.op];
+		}
+	}
+};
+
+
+/**************************************************************
+ * RobotProfile
+ *	経路のコストを計算するときに使うロボットの走行性能
+ *	デフォルトはMazeSolver_conf.hの値で、再コンパイルせずに速度などを変えて経路を比べられる
+ *	作るときにOperationCostTableを計算しておくので、値はあとから変えられない
+ *
+ *	setTurnVelocityでターンの入口、出口の速度を指定すると、OperationList::evalは速度を持ち越すモデルで計算する
+ *	  直線は前のターンの出口の速度から加速し、次のターンの入口の速度まで減速する
+ *	  ターンは入口の速度から出口の速度に変わり、指定より遅く入るとその分時間がかかる
+ *	  加速が間に合わない場合は前から、減速が間に合わない場合は後ろから速度を下げる(動作の数に比例する時間)
+ *	  スタートとゴールはminVelocity
+ *	指定しない場合は、全ての直線をminVelocityで始めて終わり、ターンは決まった時間(OperationCostTable)
+ *	全てのターンの速度をminVelocityにすると、指定しない場合と同じコストになる
+ **************************************************************/
+class RobotProfile {
+private:
+	double turn90Time;
+	double turn45Time;
+	double acceleration;
+	double maxVelocity;
+	double minVelocity;
+	double blockLength;
+	OperationCostTable costTable;
+	bool largeTurn;
+	bool velocityModel;
+	float turnEntryVelocity[Operation::STOP+1];
+	float turnExitVelocity[Operation::STOP+1];
+
+public:
+	//引数の意味はOperationCostTableと同じ
+	RobotProfile(double _turn90Time = TURN90_TIME, double _turn45Time = TURN45_TIME,
+			double _acceleration = ACCELERATION, double _maxVelocity = MAX_VELOCITY, double _minVelocity = MIN_VELOCITY,
+			double _blockLength = MAZE_1BLOCK_LENGTH)
+		: turn90Time(_turn90Time), turn45Time(_turn45Time), acceleration(_acceleration),
+		  maxVelocity(_maxVelocity), minVelocity(_minVelocity), blockLength(_blockLength),
+		  costTable(_turn90Time, _turn45Time, _acceleration, _maxVelocity, _minVelocity, _blockLength),
+		  largeTurn(USE_LARGE_TURN), velocityModel(false)
+	{
+		for (int i=0;i<=Operation::STOP;i++) turnEntryVelocity[i] = turnExitVelocity[i] = _minVelocity;
+	}
+
+	//MazeSolver_conf.hの走行性能
+	static const RobotProfile &getDefault();
+
+	inline double getTurn90Time() const { return turn90Time; }
+	inline double getTurn45Time() const { return turn45Time; }
+	inline double getAcceleration() const { return acceleration; }
+	inline double getMaxVelocity() const { return maxVelocity; }
+	inline double getMinVelocity() const { return minVelocity; }
+	inline double getBlockLength() const { return blockLength; }
+	inline const OperationCostTable &getCostTable() const { return costTable; }
+
+	//ターンの時間[s]を変える 左右の両方に同じ値を使う
+	inline void setTurnTime(Operation::OperationType turn, double time) { costTable.setTurnTime(turn, time); }
+	//大回りのターン(TURN_RIGHT90_LARGEなど)を使える機体か デフォルトはUSE_LARGE_TURN
+	//trueの場合、ShortestPathは経路をOperationListにしたあとconvertToLargeTurnする
+	inline void setLargeTurn(bool enable) { largeTurn = enable; }
+	inline bool useLargeTurn() const { return largeTurn; }
+
+	//turnの入口と出口の速度[m/s]を指定する 右と左の両方に同じ値を使う
+	void setTurnVelocity(Operation::OperationType turn, double entryVelocity, double exitVelocity);
+	inline bool useVelocityModel() const { return velocityModel; }
+	inline float getTurnEntryVelocity(Operation::OperationType turn) const { return turnEntryVelocity[turn]; }
+	inline float getTurnExitVelocity(Operation::OperationType turn) const { return turnExitVelocity[turn]; }
 };
 
 
@@ -38,13 +168,27 @@ struct Operation {
  *	コンストラクタのPathを入れると勝手に変換する
  **************************************************************/
 class OperationList {
+public:
+	//compilePath, loadFromPathの結果
+	typedef enum {
+		PATH_OK,
+		PATH_NOT_ADJACENT, 	//隣り合っていない区画が並んでいる
+		PATH_U_TURN, 		//来た区画に引き返している
+		PATH_BUFFER_FULL, 	//bufferに入りきらない
+	} PathError;
+
 private:
 	std::vector<Operation> opList;
+	//速度を持ち越すモデルで、i番目の動作に入るときの速度 evalのたびに使いまわす
+	mutable std::vector<float> boundaryVelocity;
+
+	float evalWithVelocity(const RobotProfile &profile) const;
 
 public:
 	OperationList() { }
 	//Pathをいれると勝手に変換して保持する
-	OperationList(const Path &path, bool useDiagonalPath) { loadFromPath(path, useDiagonalPath); }
+	template<size_t CAPACITY>
+	OperationList(const FixedVector<IndexVec, CAPACITY> &path, bool useDiagonalPath) { loadFromPath(path, useDiagonalPath); }
 	OperationList(const OperationList &obj) { opList = obj.opList; }
 
 	const OperationList &operator=(const OperationList &rhs)
@@ -59,19 +203,81 @@ public:
 	inline size_t size() const { return opList.size(); }
 	inline void push_back(const Operation& op) { opList.push_back(op); }
 	inline void pop_back() { opList.pop_back(); }
+	inline void clear() { opList.clear(); }
 	const Operation &operator[](size_t i) const { return opList[i]; }
 
 	//opListの全動作の合計コスト(時間)を計算して返す
 	//マシンの走行をシミュレーションしてかかる時間を計算する
 	float eval() const;
+	//表、走行性能を指定して合計コストを計算する
+	float eval(const OperationCostTable &table) const;
+	//profileでターンの速度を指定している場合は、速度を持ち越すモデルで計算する
+	//その場合は作業用の領域を使うので、同じOperationListを複数のスレッドで同時にevalしない
+	inline float eval(const RobotProfile &profile) const
+	{
+		if (profile.useVelocityModel()) return evalWithVelocity(profile);
+		return eval(profile.getCostTable());
+	}
+
+	//大回りのターンを使うOperationに変換する
+	//loadFromPathのあとに使う
+	//  直線,90度,直線 -> 直線(1区画短く),大回り90度,直線(1区画短く)
+	//  直線,90度,90度(同じ向き),直線 -> 直線(1区画短く),180度,直線(1区画短く)
+	//  90度,斜めに入る45度(同じ向き) -> 135度で斜めに入る
+	//  斜めから出る45度,90度(同じ向き) -> 135度で斜めから出る
+	//  斜めから出る45度,斜めに入る45度(同じ向き) -> V90度
+	//前から順に、長く曲がる方を優先して変換する
+	void convertToLargeTurn();
+
+	//Pathを読み込んで、FORWARDを圧縮したOperationの列をbufferに書く
+	//pathを前から1回なめるだけで、斜め区間(左右交互の連続ターン)は終わった所でまとめて書く
+	//書いた動作の数をnOpに入れる 動作の数はpath.size()-1を超えない
+	//pathがおかしい、bufferが足りない場合はエラーを返す(nOpにはそこまでに書いた数が入る)
+	//useDiagonalPath=trueにすると斜め走行ありで変換する
+	template<size_t CAPACITY>
+	static PathError compilePath(const FixedVector<IndexVec, CAPACITY>& path, bool useDiagonalPath,
+			Operation *buffer, size_t capacity, size_t &nOp);
 
 	//Path読み込む
 	//Operationに変換してメンバのOpListに保存する
 	//useDiagonalPath=trueにすると斜め走行ありで変換する
-	void loadFromPath(const Path& path, bool useDiagonalPath);
+	//opListの領域が足りていればヒープを使わない
+	//pathがおかしい場合はopListを空にしてエラーを返す
+	//PathT<16>とPathT<32>を読み込める
+	template<size_t CAPACITY>
+	PathError loadFromPath(const FixedVector<IndexVec, CAPACITY>& path, bool useDiagonalPath);
 
 	void print();
 };
 
 
+/**************************************************************
+ * RobotProfileSet
+ *	複数のRobotProfileで、1つのOperationListのコストを1回のループでまとめて計算する
+ *	各profileのOperationCostTableを、動作(op, n)ごとに全profileの値が並ぶように並べ替えて持つ
+ *	1つの動作について全profileのコストを連続して足すので、profileの方向に自動ベクトル化される
+ *	候補の経路ごとに、どの速度設定で走ると一番速いかを選ぶのに使う
+ *	OperationCostTableで計算する(ターンの速度は使わない)
+ **************************************************************/
+class RobotProfileSet {
+private:
+	std::vector<RobotProfile> profiles;
+	//[n*profiles.size() + i]がi番目のprofileでnの時のコスト
+	std::vector<float> forward;
+	std::vector<float> forwardDiag;
+	//[op*profiles.size() + i]がi番目のprofileでのターンopのコスト
+	std::vector<float> turn;
+
+public:
+	void add(const RobotProfile &profile);
+	void clear();
+	inline size_t size() const { return profiles.size(); }
+	inline const RobotProfile &operator[](size_t i) const { return profiles[i]; }
+
+	//i番目のprofileでのopListの合計コストをcost[i]に入れる
+	//costはsize()個の領域が必要
+	void eval(const OperationList &opList, float *cost) const;
+};
+
+
 #endif /* OPERATION_H_ */
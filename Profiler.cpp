@@ -0,0 +1,83 @@
+#include <cstdio>
+
+#include "MazeSolver_conf.h"
+#include "Profiler.h"
+
+#ifndef PROFILE_CLOCK_HZ
+#define PROFILE_CLOCK_HZ 	1000000000
+#endif
+
+
+ProfileStat Profiler::stat[PROFILE_POINT_MAX];
+
+void Profiler::record(ProfilePoint point, uint64_t tick)
+{
+	ProfileStat &s = stat[point];
+	s.count++;
+	s.total += tick;
+	if (tick > s.max) s.max = tick;
+
+	//tickの2進数の桁数-1が区間の番号
+	int bin = 0;
+	while ((tick >> 1) != 0 && bin < PROFILE_HISTOGRAM_SIZE-1) {
+		tick >>= 1;
+		bin++;
+	}
+	s.histogram[bin]++;
+}
+
+void Profiler::clear()
+{
+	for (int i=0;i<PROFILE_POINT_MAX;i++) {
+		stat[i].count = 0;
+		stat[i].total = 0;
+		stat[i].max = 0;
+		for (int j=0;j<PROFILE_HISTOGRAM_SIZE;j++) stat[i].histogram[j] = 0;
+	}
+}
+
+const char *Profiler::getName(ProfilePoint point)
+{
+	static const char *name[PROFILE_POINT_MAX] = {
+		"Agent::update",
+		"Agent::update(IDLE)",
+		"Agent::update(SEARCHING_NOT_GOAL)",
+		"Agent::update(SEARCHING_REACHED_GOAL)",
+		"Agent::update(BACK_TO_START)",
+		"Agent::update(FINISHED)",
+		"Maze::updateStepMap",
+		"ShortestPath::calcKShortestDistancePath",
+		"Agent::caclRunSequence",
+	};
+	return name[point];
+}
+
+double Profiler::toSecond(uint64_t tick)
+{
+	return (double)tick/PROFILE_CLOCK_HZ;
+}
+
+void Profiler::print()
+{
+#if !MAZESOLVER_PROFILE
+	std::printf("profile disabled (MAZESOLVER_PROFILE=0)\n");
+#endif
+	std::printf("%-40s %10s %12s %12s\n", "", "count", "mean[us]", "max[us]");
+	for (int i=0;i<PROFILE_POINT_MAX;i++) {
+		const ProfileStat &s = stat[i];
+		if (s.count == 0) continue;
+		std::printf("%-40s %10u %12.3f %12.3f\n", getName((ProfilePoint)i), (unsigned)s.count,
+				toSecond(s.total)*1e6/s.count, toSecond(s.max)*1e6);
+	}
+
+	//区間の下限の時間と回数 回数が0の区間は省く
+	for (int i=0;i<PROFILE_POINT_MAX;i++) {
+		const ProfileStat &s = stat[i];
+		if (s.count == 0) continue;
+		std::printf("%s\n", getName((ProfilePoint)i));
+		for (int j=0;j<PROFILE_HISTOGRAM_SIZE;j++) {
+			if (s.histogram[j] == 0) continue;
+			std::printf("  >= %12.3f us : %u\n", (j == 0) ? 0.0 : toSecond((uint64_t)1 << j)*1e6, (unsigned)s.histogram[j]);
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <cstdint>
+#include "MazeSolver_conf.h"
+
+//時計を指定していない場合はstd::chrono::steady_clockをnsで使う
+#if MAZESOLVER_PROFILE && !defined(PROFILE_CLOCK)
+#include <chrono>
+#define PROFILE_CLOCK() 	((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#define PROFILE_CLOCK_HZ 	1000000000
+#endif
+
+
+//計測する場所
+//Agent::updateは全体(PROFILE_AGENT_UPDATE)と、呼ばれたときのAgentの状態ごとの両方に記録する
+typedef enum {
+	PROFILE_AGENT_UPDATE,
+	PROFILE_AGENT_UPDATE_IDLE,
+	PROFILE_AGENT_UPDATE_SEARCHING_NOT_GOAL,
+	PROFILE_AGENT_UPDATE_SEARCHING_REACHED_GOAL,
+	PROFILE_AGENT_UPDATE_BACK_TO_START,
+	PROFILE_AGENT_UPDATE_FINISHED,
+	PROFILE_MAZE_UPDATE_STEPMAP,
+	PROFILE_KSHORTEST_PATH,
+	PROFILE_RUN_SEQUENCE,
+	PROFILE_POINT_MAX
+} ProfilePoint;
+
+//ヒストグラムの区間の数
+//i番目はかかった時間が2^i tick以上2^(i+1) tick未満の回数(0 tickは0番目、最後の区間はそれ以上全部)
+#define PROFILE_HISTOGRAM_SIZE 	32
+
+struct ProfileStat {
+	uint32_t count;		//呼び出し回数
+	uint64_t total;		//合計時間[tick]
+	uint64_t max;		//最悪時間[tick]
+	uint32_t histogram[PROFILE_HISTOGRAM_SIZE];
+};
+
+
+/**************************************************************
+ * Profiler
+ *	計測する場所ごとに、呼び出し回数、合計時間、最悪時間、時間のヒストグラムを記録する
+ *	MazeSolver_conf.hのMAZESOLVER_PROFILEが1のときだけ記録する(0のときはPROFILE_SCOPEが空になり、何も増えない)
+ *	時計はPROFILE_CLOCK()とPROFILE_CLOCK_HZで差し替えられる(マイコンではサイクルカウンタなど)
+ *
+ *	記録する場所は全体で1つなので、計測する関数を複数のスレッドで同時に呼ばないこと
+ *	(test/simulate.cppで使う場合は-j 1にする)
+ *
+ *	使い方
+ *	Profiler::clear();
+ *	//探索、最終的な経路の計算
+ *	Profiler::print(); //場所ごとの表とヒストグラムをprintfで出す
+ *	Profiler::getStat(PROFILE_AGENT_UPDATE).max; //Agent::updateの最悪時間[tick]
+ **************************************************************/
+class Profiler {
+private:
+	static ProfileStat stat[PROFILE_POINT_MAX];
+
+public:
+	//pointにかかった時間tickを記録する
+	static void record(ProfilePoint point, uint64_t tick);
+	static void clear();
+
+	static inline const ProfileStat &getStat(ProfilePoint point) { return stat[point]; }
+	static const char *getName(ProfilePoint point);
+	//tickを秒にする
+	static double toSecond(uint64_t tick);
+
+	static void print();
+};
+
+
+#if MAZESOLVER_PROFILE
+/**************************************************************
+ * ProfileScope
+ *	作ってから壊すまでの時間をProfilerに記録する
+ *	直接使わずにPROFILE_SCOPE(point)またはPROFILE_SCOPE(point, subPoint)と書く
+ **************************************************************/
+class ProfileScope {
+private:
+	typedef decltype(PROFILE_CLOCK()) Tick;
+	ProfilePoint point;
+	ProfilePoint subPoint;
+	Tick start;
+
+public:
+	//subPointがPROFILE_POINT_MAXでなければ、そこにも同じ時間を記録する
+	ProfileScope(ProfilePoint _point, ProfilePoint _subPoint = PROFILE_POINT_MAX)
+		: point(_point), subPoint(_subPoint), start(PROFILE_CLOCK()) {}
+	~ProfileScope()
+	{
+		//時計が1周しても差は正しい
+		const Tick elapsed = (Tick)(PROFILE_CLOCK() - start);
+		Profiler::record(point, elapsed);
+		if (subPoint != PROFILE_POINT_MAX) Profiler::record(subPoint, elapsed);
+	}
+};
+#define PROFILE_SCOPE(...) 	ProfileScope profileScope(__VA_ARGS__)
+#else
+#define PROFILE_SCOPE(...)
+#endif
+
+
+#endif /* PROFILER_H_ */
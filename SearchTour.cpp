@@ -0,0 +1,164 @@
+#include <algorithm>
+
+#include "MazeSolver_conf.h"
+#include "SearchTour.h"
+
+
+template<int N>
+uint32_t SearchTourT<N>::calcLength(DistanceOracleT<N> &oracle) const
+{
+	uint32_t sum = 0;
+	for (size_t i=0;i<=tour.size();i++) sum += cost(oracle, i, i+1);
+	return sum;
+}
+
+template<int N>
+void SearchTourT<N>::insertCheapest(DistanceOracleT<N> &oracle, const IndexVec &index)
+{
+	//at(p)とat(p+1)の間に入れたときに増える歩数が一番小さいところ
+	size_t best = 0;
+	int32_t bestCost = INT32_MAX;
+	for (size_t p=0;p<=tour.size();p++) {
+		const int32_t increase = (int32_t)cost(oracle, p, index) + cost(oracle, p+1, index) - cost(oracle, p, p+1);
+		if (increase < bestCost) {
+			bestCost = increase;
+			best = p;
+		}
+	}
+	tour.push_back(index);
+	std::rotate(tour.begin() + best, tour.end() - 1, tour.end());
+}
+
+template<int N>
+void SearchTourT<N>::construct(DistanceOracleT<N> &oracle, const IndexList &targets)
+{
+	//startから到達できない区画は回れない
+	IndexList reachable;
+	for (auto &index : targets) {
+		if (oracle.getDistance(start, index) != MazeT<N>::STEP_MAX) reachable.push_back(index);
+	}
+
+	//前回の順番に残っている区画はそのままの順番で使う
+	const IndexList prev(tour);
+	tour.clear();
+	for (auto &index : prev) {
+		if (std::find(reachable.begin(), reachable.end(), index) != reachable.end()) tour.push_back(index);
+	}
+
+	if (tour.empty()) {
+		//startから一番近い区画を順にたどる
+		IndexVec cur = start;
+		while (!reachable.empty()) {
+			auto nearest = reachable.begin();
+			for (auto it = reachable.begin();it != reachable.end();it++) {
+				if (oracle.getDistance(cur, *it) < oracle.getDistance(cur, *nearest)) nearest = it;
+			}
+			cur = *nearest;
+			tour.push_back(cur);
+			reachable.erase(nearest);
+		}
+		return;
+	}
+
+	//新しい区画は一番歩数が増えないところに挿入する
+	for (auto &index : reachable) {
+		if (std::find(tour.begin(), tour.end(), index) == tour.end()) insertCheapest(oracle, index);
+	}
+}
+
+template<int N>
+bool SearchTourT<N>::improveByTwoOpt(DistanceOracleT<N> &oracle, uint32_t budget)
+{
+	//at(i)〜at(j)を逆順にする
+	const size_t k = tour.size();
+	for (size_t i=1;i<k;i++) {
+		for (size_t j=i+1;j<=k;j++) {
+			if (nEval >= budget) return false;
+			nEval++;
+			const int32_t delta = (int32_t)cost(oracle, i-1, j) + cost(oracle, i, j+1) - cost(oracle, i-1, i) - cost(oracle, j, j+1);
+			if (delta < 0) {
+				std::reverse(tour.begin() + (i-1), tour.begin() + j);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+template<int N>
+bool SearchTourT<N>::improveByOrOpt(DistanceOracleT<N> &oracle, uint32_t budget)
+{
+	//at(i)〜at(i+len-1)の区間を抜き出して、at(j)とat(j+1)の間に入れる(向きはどちらでもよい)
+	const size_t k = tour.size();
+	for (size_t len=1;len<=3 && len<k;len++) {
+		for (size_t i=1;i+len-1<=k;i++) {
+			const size_t last = i+len-1;
+			const int32_t removeGain = (int32_t)cost(oracle, i-1, i) + cost(oracle, last, i+len) - cost(oracle, i-1, i+len);
+
+			for (size_t j=0;j<=k;j++) {
+				if (j+1 >= i && j < i+len) continue;
+				if (nEval >= budget) return false;
+				nEval++;
+
+				const int32_t edge = cost(oracle, j, j+1);
+				const int32_t forward = (int32_t)cost(oracle, j, i) + cost(oracle, last, j+1) - edge;
+				const int32_t backward = (int32_t)cost(oracle, j, last) + cost(oracle, i, j+1) - edge;
+				if (std::min(forward, backward) >= removeGain) continue;
+
+				//区間はtour[i-1]〜tour[i+len-2]
+				const auto segBegin = tour.begin() + (i-1);
+				const auto segEnd = segBegin + len;
+				if (backward < forward) std::reverse(segBegin, segEnd);
+				if (j < i) std::rotate(tour.begin() + j, segBegin, segEnd);
+				else std::rotate(segBegin, segEnd, tour.begin() + j);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+template<int N>
+void SearchTourT<N>::improve(DistanceOracleT<N> &oracle, uint32_t budget)
+{
+	nEval = 0;
+	while (improveByTwoOpt(oracle, budget) || improveByOrOpt(oracle, budget));
+	length = calcLength(oracle);
+}
+
+template<int N>
+void SearchTourT<N>::plan(DistanceOracleT<N> &oracle, const IndexVec &_start, const IndexList &targets, uint32_t budget)
+{
+	start = _start;
+	construct(oracle, targets);
+	improve(oracle, budget);
+}
+
+template<int N>
+void SearchTourT<N>::replan(DistanceOracleT<N> &oracle, const IndexVec &_start, uint32_t budget)
+{
+	const IndexList targets(tour);
+	start = _start;
+	construct(oracle, targets);
+	improve(oracle, budget);
+}
+
+template<int N>
+bool SearchTourT<N>::retain(DistanceOracleT<N> &oracle, const IndexList &targets)
+{
+	const size_t prevSize = tour.size();
+	for (auto it = tour.begin();it != tour.end();) {
+		if (std::find(targets.begin(), targets.end(), *it) == targets.end()) {
+			it = tour.erase(it);
+			continue;
+		}
+		it++;
+	}
+	if (tour.size() == prevSize) return false;
+	length = calcLength(oracle);
+	return true;
+}
+
+//使う大きさの迷路の実体をつくる
+template class SearchTourT<16>;
+template class SearchTourT<32>;
@@ -0,0 +1,98 @@
+#ifndef SEARCHTOUR_H_
+#define SEARCHTOUR_H_
+
+#include <cstdint>
+#include "MazeSolver_conf.h"
+#include "Maze.h"
+#include "DistanceOracle.h"
+
+
+/**************************************************************
+ * SearchTourT
+ *	探索しなければならない区画を全て回る順番(巡回セールスマン問題の経路)を計算する
+ *	start -> tour[0] -> tour[1] -> ... -> tour.back() の歩数の合計を短くする
+ *	最後に着く区画は決めない(スタートに戻ることまで考えると、遠い区画から先に回ることになり、
+ *	途中で暫定最短経路が変わったときに無駄に走ることが多かった)
+ *	歩数はDistanceOracleの表を引く
+ *	N:迷路の大きさ
+ *
+ *	plan
+ *		前回の順番に残っている区画はその順番のまま使い、新しい区画は一番歩数が増えないところに挿入する
+ *		前回の順番が使えないときは、startから一番近い区画を順にたどって作る
+ *		startから到達できない区画は入れない
+ *	retain
+ *		探索し終わった区画を除くだけで、順番は変えない
+ *	replan
+ *		区画はそのままで、startだけを変えて順番を改善しなおす(壁が増えて歩数が変わったとき)
+ *
+ *	planとreplanは最後に2-optとOr-opt(1〜3区画の区間を別の場所に移す)で改善する
+ *	改善は手を評価した回数がbudgetに達したら打ち切る(マイコン上で時間を見積もりやすいように)
+ *
+ *	使い方
+ *	SearchTour tour;
+ *	tour.plan(oracle, IndexVec(3,4), targets, 4096);
+ *	tour.getTour().front(); //最初に向かう区画
+ **************************************************************/
+template<int N>
+class SearchTourT {
+public:
+	typedef IndexListT<N> IndexList;
+
+private:
+	//回る順番 startは含まない
+	IndexList tour;
+	IndexVec start;
+
+	//start->tourの歩数
+	uint32_t length;
+	//最後のplan/replanで手を評価した回数
+	uint32_t nEval;
+
+	//i=0がstart、1〜tour.size()がtour
+	inline const IndexVec &at(size_t i) const { return (i == 0) ? start : tour[i-1]; }
+	//at(i)とat(j)の間の歩数
+	//tour.size()+1番目は最後の区画のあとの終点で、どこからでも0歩とする(最後の区画で終わってよいので)
+	inline uint32_t cost(DistanceOracleT<N> &oracle, size_t i, size_t j) const
+	{
+		if (i > tour.size() || j > tour.size()) return 0;
+		return oracle.getDistance(at(i), at(j));
+	}
+	//at(i)とindexの間の歩数
+	inline uint32_t cost(DistanceOracleT<N> &oracle, size_t i, const IndexVec &index) const
+	{
+		if (i > tour.size()) return 0;
+		return oracle.getDistance(at(i), index);
+	}
+	uint32_t calcLength(DistanceOracleT<N> &oracle) const;
+
+	void construct(DistanceOracleT<N> &oracle, const IndexList &targets);
+	void insertCheapest(DistanceOracleT<N> &oracle, const IndexVec &index);
+	//改善できたらtrue
+	bool improveByTwoOpt(DistanceOracleT<N> &oracle, uint32_t budget);
+	bool improveByOrOpt(DistanceOracleT<N> &oracle, uint32_t budget);
+	void improve(DistanceOracleT<N> &oracle, uint32_t budget);
+
+public:
+	SearchTourT() : start(0,0), length(0), nEval(0) {}
+
+	//startからtargetsを全て回る順番を計算する
+	//oracleはsyncしてから渡す
+	void plan(DistanceOracleT<N> &oracle, const IndexVec &_start, const IndexList &targets, uint32_t budget);
+	//今の順番からstartを変えて改善しなおす
+	//oracleはsyncしてから渡す
+	void replan(DistanceOracleT<N> &oracle, const IndexVec &_start, uint32_t budget);
+
+	//targetsにない区画を順番から除く(残りの順番は変えない)
+	//除いた区画があればtrue
+	bool retain(DistanceOracleT<N> &oracle, const IndexList &targets);
+
+	inline void clear() { tour.clear(); length = 0; nEval = 0; }
+	inline const IndexList &getTour() const { return tour; }
+	inline uint32_t getLength() const { return length; }
+	inline uint32_t getEvalCount() const { return nEval; }
+};
+
+typedef SearchTourT<MAZE_SIZE> SearchTour;
+
+
+#endif /* SEARCHTOUR_H_ */
@@ -3,26 +3,121 @@
 #include <cmath>
 #include <utility>
 #include <algorithm>
+#include <functional>
+#if KSHORTEST_PATH_THREADS > 1
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
 
 #include "MazeSolver_conf.h"
 #include "ShortestPath.h"
+#include "Profiler.h"
+
+
+#if KSHORTEST_PATH_THREADS > 1
+/**************************************************************
+ * SpurThreads
+ *	k shortest pathのspur nodeの計算に使うスレッド
+ *	コンストラクタでKSHORTEST_PATH_THREADS-1個のスレッドを作っておき、
+ *	run()を呼ぶたびに呼び出したスレッドも含めた全スレッドでfunc(スレッド番号)を1回ずつ実行する
+ *	kごとにスレッドを作ると、1回の計算が短い16x16の迷路では作る時間の方が長くなる
+ **************************************************************/
+class SpurThreads {
+private:
+	std::function<void(int)> func;
+	std::vector<std::thread> threads;
+	std::mutex mtx;
+	std::condition_variable startCond;
+	std::condition_variable doneCond;
+	int generation;
+	int nRunning;
+	bool quit;
+
+	void threadMain(int t)
+	{
+		int doneGeneration = 0;
+		while (1) {
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				startCond.wait(lock, [&]{ return quit || generation != doneGeneration; });
+				if (quit) return;
+				doneGeneration = generation;
+			}
+			func(t);
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				if (--nRunning == 0) doneCond.notify_one();
+			}
+		}
+	}
+
+public:
+	SpurThreads(const std::function<void(int)> &_func) : func(_func), generation(0), nRunning(0), quit(false)
+	{
+		for (int t=1;t<KSHORTEST_PATH_THREADS;t++) {
+			threads.push_back(std::thread(&SpurThreads::threadMain, this, t));
+		}
+	}
+
+	~SpurThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			quit = true;
+		}
+		startCond.notify_all();
+		for (std::thread &thread : threads) thread.join();
+	}
+
+	void run()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			nRunning = threads.size();
+			generation++;
+		}
+		startCond.notify_all();
+		func(0);
+
+		std::unique_lock<std::mutex> lock(mtx);
+		doneCond.wait(lock, [&]{ return nRunning == 0; });
+	}
+};
+#endif
 
 
-int ShortestPath::calcShortestDistancePath(const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall)
+//同じ経路かどうかを比べるための経路のハッシュ(FNV-1a)
+template<size_t CAPACITY>
+static uint64_t calcPathHash(const FixedVector<IndexVec, CAPACITY> &path)
 {
-	std::list<IndexVec> goalList;
+	uint64_t hash = 14695981039346656037ULL;
+	for (const IndexVec &index : path) {
+		hash = (hash ^ (uint8_t)index.x) * 1099511628211ULL;
+		hash = (hash ^ (uint8_t)index.y) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+template<int N>
+int ShortestPathT<N>::calcShortestDistancePath(const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall)
+{
+	IndexList goalList;
 	goalList.push_back(goal);
 	return calcShortestDistancePath(start, goalList,onlyUseFoundWall);
 }
 
 
-int ShortestPath::calcShortestDistancePath(const IndexVec &start, const std::list<IndexVec> &goalList, bool onlyUseFoundWall)
+template<int N>
+int ShortestPathT<N>::calcShortestDistancePath(const IndexVec &start, const IndexList &goalList, bool onlyUseFoundWall)
 {
 	shortestDistancePath.clear();
 
-	maze->updateStepMap(goalList.front(), onlyUseFoundWall);
+	//goalListの全ての座標を歩数0にするので、startの歩数が一番近いゴールまでの歩数になる
+	maze->updateStepMap(goalList, onlyUseFoundWall);
 
-	if (maze->getStepMap(start) == 0xff) return false;
+	if (maze->getStepMap(start) == MazeT<N>::STEP_MAX) return false;
 
 	//歩数マップを下る方向に
 	IndexVec cur = start;
@@ -30,18 +125,15 @@ int ShortestPath::calcShortestDistancePath(const IndexVec &start, const std::lis
 		shortestDistancePath.push_back(cur);
 
 		//goalListのどこかにたどり着いたらおわり
-		auto it = std::find(goalList.begin(), goalList.end(), cur);
-		if (it != goalList.end()) {
-			break;
-		}
+		if (maze->getStepMap(cur) == 0) break;
 
-		const uint8_t curStep = maze->getStepMap(cur);
+		const typename MazeT<N>::Step curStep = maze->getStepMap(cur);
 		for (int i=0;i<4;i++) {
 			if (maze->getWall(cur)[i]) continue;
 
-			if (cur.canSum(IndexVec::vecDir[i])) {
+			if (cur.canSum(IndexVec::vecDir[i], N)) {
 				const IndexVec neighbor = cur + IndexVec::vecDir[i];
-				const uint8_t neighborStep = maze->getStepMap(neighbor);
+				const typename MazeT<N>::Step neighborStep = maze->getStepMap(neighbor);
 				if (neighborStep == curStep-1) {
 					cur = neighbor;
 					break;
@@ -53,44 +145,212 @@ int ShortestPath::calcShortestDistancePath(const IndexVec &start, const std::lis
 	return true;
 }
 
-void ShortestPath::removeNode(const IndexVec& node)
+template<int N>
+int ShortestPathT<N>::calcSpurPath(SpurWorker &worker, const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall)
+{
+	typedef typename MazeT<N>::Step Step;
+	worker.spurPath.clear();
+
+	//goalを0とした歩数マップ
+	//計算の中身はMaze::updateStepMapと同じで、壁はworkerのremovedEdge,removedNodeも含めて考える
+	Step stepMap[N][N];
+	for (int i=0;i<N;i++) {
+		for (int j=0;j<N;j++) {
+			stepMap[i][j] = MazeT<N>::STEP_MAX;
+		}
+	}
+	stepMap[goal.y][goal.x] = 0;
+
+	//各座標は一度しか入らないので、迷路の区画数分あれば足りる
+	IndexVec q[N*N];
+	int q_head = 0, q_tail = 0;
+	q[q_tail++] = goal;
+
+	//startの歩数が決まればそこから下っていけるので、迷路全体は計算しない
+	while (q_head != q_tail && stepMap[start.y][start.x] == MazeT<N>::STEP_MAX) {
+		const IndexVec cur = q[q_head++];
+
+		const Direction cur_wall = getWallWithRemoved(worker, cur);
+		for (int i=0;i<4;i++) {
+			const IndexVec scanIndex = cur + IndexVec::vecDir[i];
+			const Step curStep = stepMap[cur.y][cur.x];
+			if (!cur_wall[i] && stepMap[scanIndex.y][scanIndex.x] > curStep +1) {
+				//未探索壁をどうするか
+				if (onlyUseFoundWall && !cur_wall[i+4]) continue;
+
+				stepMap[scanIndex.y][scanIndex.x] = curStep +1;
+
+				//袋小路でない場合はqueueに入れる
+				if (getWallWithRemoved(worker, scanIndex).nWall() != 3) {
+					q[q_tail++] = scanIndex;
+				}
+			}
+		}
+	}
+
+	if (stepMap[start.y][start.x] == MazeT<N>::STEP_MAX) return false;
+
+	//歩数マップを下る方向に
+	IndexVec cur = start;
+	while (1) {
+		worker.spurPath.push_back(cur);
+		if (cur == goal) break;
+
+		const Step curStep = stepMap[cur.y][cur.x];
+		const Direction cur_wall = getWallWithRemoved(worker, cur);
+		for (int i=0;i<4;i++) {
+			if (cur_wall[i]) continue;
+
+			if (cur.canSum(IndexVec::vecDir[i], N)) {
+				const IndexVec neighbor = cur + IndexVec::vecDir[i];
+				if (stepMap[neighbor.y][neighbor.x] == curStep-1) {
+					cur = neighbor;
+					break;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+template<int N>
+void ShortestPathT<N>::RemovedWall::add(const IndexVec& cur, const Direction& newState)
+{
+	//Maze::updateWall(forceSetDone=true)と同じビットを立てる
+	auto addBits = [this](const IndexVec &_index, uint8_t bits) {
+		uint8_t &removed = wall[_index.y][_index.x];
+		if (removed == 0 && bits != 0) index.push_back(_index);
+		removed |= bits;
+	};
+
+	addBits(cur, newState | (uint8_t)0xf0);
+	for (int i=0;i<4;i++) {
+		if (cur.canSum(IndexVec::vecDir[i], N)) {
+			addBits(cur + IndexVec::vecDir[i], (0x10 | newState[i]) << (i+2)%4);
+		}
+	}
+}
+
+template<int N>
+void ShortestPathT<N>::RemovedWall::restore()
 {
-	maze->updateWall(node, Direction(0xff));
+	for (const IndexVec &_index : index) {
+		wall[_index.y][_index.x] = 0;
+	}
+	index.clear();
 }
 
+template<int N>
+void ShortestPathT<N>::removeNode(SpurWorker &worker, const IndexVec& node)
+{
+	worker.removedNode.add(node, Direction(0xff));
+}
 
-void ShortestPath::removeEdge(const IndexVec& start, const IndexVec& end)
+
+template<int N>
+void ShortestPathT<N>::removeEdge(SpurWorker &worker, const IndexVec& start, const IndexVec& end)
 {
 	const IndexVec dxdy = end - start;
 	for (int i=0;i<4;i++) {
 		if (dxdy == IndexVec::vecDir[i]) {
-			maze->updateWall(start, Direction(0x11<<i));
+			worker.removedEdge.add(start, Direction(0x11<<i));
 			break;
 		}
 	}
 }
 
-bool ShortestPath::matchPath(const Path &path1, const Path &path2, int n)
+template<int N>
+bool ShortestPathT<N>::matchPath(const Path &path1, const Path &path2, size_t n)
+{
+	if (path1.size() < n || path2.size() < n) return false;
+
+	for (size_t i=0;i<n;i++) {
+		if (path1[i] != path2[i]) return false;
+	}
+
+	return true;
+}
+
+template<int N>
+void ShortestPathT<N>::calcSpurCandidate(SpurWorker &worker, size_t i, bool onlyUseFoundWall, Path &candidate)
 {
-	bool result = true;
+	const Path &prevPath = k_shortestDistancePath.back();
+	const IndexVec &spurNode = prevPath[i];
+	const IndexVec &spurGoal = prevPath.back();
+	candidate.clear();
+
+	//spurNodeを残して、それまでのrootPath上のNodeを削除する
+	//直後のspurNode->ゴールまでの最短経路の計算で無駄な経路を含まないため
+	//rootPathは1つずつ伸びるので、増えたNodeだけを足していく
+	while (worker.nRemovedNode < i) {
+		removeNode(worker, prevPath[worker.nRemovedNode++]);
+	}
+
+	if (maze->getWall(spurNode).nWall() > 1) return;
+
+	Path rootPath(prevPath.begin(), prevPath.begin()+i+1);
+
+	for (const Path &p :k_shortestDistancePath) {
+		if (p.size() > i+1 && matchPath(p, rootPath, rootPath.size())) {
+			if (maze->getWall(p[i]).nWall() > 1) continue;
+			//i+1とiを結ぶノードを切断
+			removeEdge(worker, p[i], p[i+1]);
+		}
+	}
+
+	//ゴールまでいける場合
+	if (calcSpurPath(worker, spurNode, spurGoal, onlyUseFoundWall) != 0) {
+		rootPath.pop_back();
+		std::copy(worker.spurPath.begin(),worker.spurPath.end(), std::back_inserter(rootPath));
+		candidate = rootPath;
+	}
 
-	for (int i=0;i<n;i++) {
-		if (path1[i] != path2[i]) result = false;
+	//削除したpathを戻す
+	worker.removedEdge.restore();
+}
+
+template<int N>
+bool ShortestPathT<N>::insertPathHash(uint64_t hash)
+{
+	//0は空きを表すので使わない
+	if (hash == 0) hash = 1;
+
+	//半分より埋まったら大きくして入れなおす
+	if (2*(nPathHash+1) > pathHash.size()) {
+		std::vector<uint64_t> old;
+		old.swap(pathHash);
+		pathHash.assign(old.empty() ? 64 : 2*old.size(), 0);
+		nPathHash = 0;
+		for (uint64_t oldHash : old) {
+			if (oldHash != 0) insertPathHash(oldHash);
+		}
 	}
 
-	return result;
+	const size_t mask = pathHash.size() - 1;
+	for (size_t i = hash & mask;;i = (i+1) & mask) {
+		if (pathHash[i] == hash) return false;
+		if (pathHash[i] == 0) {
+			pathHash[i] = hash;
+			nPathHash++;
+			return true;
+		}
+	}
 }
 
-int ShortestPath::calcKShortestDistancePath(const IndexVec &start, const IndexVec &goal, int _k, bool onlyUseFoundWall)
+template<int N>
+int ShortestPathT<N>::calcKShortestDistancePath(const IndexVec &start, const IndexVec &goal, int _k, bool onlyUseFoundWall)
 {
-	std::list<IndexVec> goalList;
+	IndexList goalList;
 	goalList.push_back(goal);
 	return calcKShortestDistancePath(start, goalList, _k, onlyUseFoundWall);
 }
 
 //Yen's k shortest path algorithm
-int ShortestPath::calcKShortestDistancePath(const IndexVec &start, const std::list<IndexVec> &goalList, int _k, bool onlyUseFoundWall)
+template<int N>
+int ShortestPathT<N>::calcKShortestDistancePath(const IndexVec &start, const IndexList &goalList, int _k, bool onlyUseFoundWall)
 {
+	PROFILE_SCOPE(PROFILE_KSHORTEST_PATH);
 	//k=1の時は最短経路のみを計算しておわり
 	if (_k == 1) {
 		if (calcShortestDistancePath(start, goalList, onlyUseFoundWall) == 0) return 0;
@@ -99,108 +359,90 @@ int ShortestPath::calcKShortestDistancePath(const IndexVec &start, const std::li
 		return 1;
 	}
 
-	//mazeを一旦退避
-	//書き換えるようにあたらしいものをつくって差し替える
-	//TODO:差し替えるてもちゃんとstepmapが更新されるかチェック
-	//TODO:差し替えではなく、変更部分だけを後で修復したほうがはやいと思う
-	Maze *tmpMaze = maze;
-	Maze newMaze(*tmpMaze);
-	maze = &newMaze;
+	//経路の削除はmazeを書き換えずにspurWorkerに記録する
+	for (SpurWorker &worker : spurWorker) worker.restore();
 
 	k_shortestDistancePath.clear();
-	std::list< Path > B;
+	//Bは経路の長さが短い順、同じ長さなら入れた順に取り出すheap
+	//一度Bに入れた経路とk_shortestDistancePathの経路はpathHashで覚えておき、同じ経路は入れない
+	B.clear();
+	std::fill(pathHash.begin(), pathHash.end(), 0);
+	nPathHash = 0;
+	uint32_t nCandidate = 0;
 
 	if (calcShortestDistancePath(start, goalList, onlyUseFoundWall) == 0) return 0;
 	k_shortestDistancePath.push_back(shortestDistancePath);
+	insertPathHash(calcPathHash(shortestDistancePath));
 
 
-	for (int k=1;k<_k;k++) {
-		for (size_t i=0;i<k_shortestDistancePath[k-1].size();i++) {
-			IndexVec &spurNode = k_shortestDistancePath[k-1][i];
-			IndexVec &spurGoal = k_shortestDistancePath[k-1].back();
-
-			if (maze->getWall(spurNode).nWall() > 1) continue;
-
-			Path rootPath(k_shortestDistancePath[k-1].begin(), k_shortestDistancePath[k-1].begin()+i+1);
-
-			for (const Path &p :k_shortestDistancePath) {
-				if (matchPath(p, rootPath, rootPath.size())) {
-					if (maze->getWall(p[i]).nWall() > 1) continue;
-					//i+1とiを結ぶノードを切断
-					removeEdge(p[i], p[i+1]);
-				}
-			}
-
-			//spurNodeを残して、それまでのrootPath上のNodeを削除する
-			//直後のspurNode->ゴールまでの最短経路の計算で無駄な経路を含まないため
-			for (const IndexVec &rootPathNode : rootPath) {
-				if (rootPathNode == spurNode) continue;
-				//rootPathNodeを削除する
-				removeNode(rootPathNode);
-			}
-
-			//ゴールまでいける場合
-			if (calcShortestDistancePath(spurNode, spurGoal, onlyUseFoundWall) != 0) {
-				auto &spurPath = shortestDistancePath;
-				rootPath.pop_back();
-				std::copy(spurPath.begin(),spurPath.end(), std::back_inserter(rootPath));
-
-				//唯一になるようにいれる
-				auto rootPath_Pos_inB = std::find(B.begin(), B.end(), rootPath);
-				if (rootPath_Pos_inB == B.end()) {
-					B.push_back(rootPath);
-				}
-			}
+	//spur nodeごとの計算は互いに関係ないので、結果をspur nodeの順にcandidateに並べておいてからBに入れる
+#if KSHORTEST_PATH_THREADS > 1
+	//空いたスレッドから次のspur nodeを取っていく
+	//各スレッドが取るspur nodeの番号は増えていくので、removedNodeはスレッドごとに足していける
+	std::atomic<size_t> nextSpur(0);
+	SpurThreads threads([&](int t) {
+		for (size_t i=nextSpur++;i<candidate.size();i=nextSpur++) {
+			calcSpurCandidate(spurWorker[t], i, onlyUseFoundWall, candidate[i]);
+		}
+		spurWorker[t].restore();
+	});
+#endif
 
-			//削除したpathとnodeを戻す
-			//placement new でもっかいコンストラクタを読んでる
-			maze = new(maze) Maze(*tmpMaze);
+	for (int k=1;k<_k;k++) {
+		candidate.assign(k_shortestDistancePath[k-1].size(), Path());
+#if KSHORTEST_PATH_THREADS > 1
+		nextSpur = 0;
+		threads.run();
+#else
+		for (size_t i=0;i<candidate.size();i++) {
+			calcSpurCandidate(spurWorker[0], i, onlyUseFoundWall, candidate[i]);
 		}
+		spurWorker[0].restore();
+#endif
 
-		//BからAにすでに含まれているものを削除する
-		for (auto it=B.begin();it!=B.end();) {
-			std::vector<IndexVec> Bitem((*it).begin(),(*it).end());
-			if (std::find(k_shortestDistancePath.begin(),k_shortestDistancePath.end(), Bitem) != k_shortestDistancePath.end()) {
-				it = B.erase(it);
-				continue;
+		for (const Path &path : candidate) {
+			if (path.empty()) continue;
+
+			//唯一になるようにいれる
+			if (insertPathHash(calcPathHash(path))) {
+				B.push_back(PathCandidate(path.size(), nCandidate++, path));
+				std::push_heap(B.begin(), B.end(), std::greater<PathCandidate>());
 			}
-			it++;
 		}
 
 		if (B.empty()) break;
 
-		B.sort( [](const Path &x, const Path &y){return x.size() < y.size();} );
-
-		k_shortestDistancePath.push_back(B.front());
-		B.pop_front();
+		std::pop_heap(B.begin(), B.end(), std::greater<PathCandidate>());
+		k_shortestDistancePath.push_back(B.back().path);
+		B.pop_back();
 	}
 
-	maze = tmpMaze;
-
 	return k_shortestDistancePath.size();
 }
 
-int ShortestPath::calcShortestTimePath(const IndexVec &start, const IndexVec &goal, int k, bool onlyUseFoundWall, bool useDiagonalPath)
+template<int N>
+int ShortestPathT<N>::calcShortestTimePath(const IndexVec &start, const IndexVec &goal, int k, bool onlyUseFoundWall, bool useDiagonalPath, const RobotProfile &profile)
 {
-	std::list<IndexVec> goalList;
+	IndexList goalList;
 	goalList.push_back(goal);
-	return calcShortestTimePath(start, goalList, k, onlyUseFoundWall, useDiagonalPath);
+	return calcShortestTimePath(start, goalList, k, onlyUseFoundWall, useDiagonalPath, profile);
 }
 
-int ShortestPath::calcShortestTimePath(const IndexVec &start, const std::list<IndexVec> &goalList, int k, bool onlyUseFoundWall, bool useDiagonalPath)
+template<int N>
+int ShortestPathT<N>::calcShortestTimePath(const IndexVec &start, const IndexList &goalList, int k, bool onlyUseFoundWall, bool useDiagonalPath, const RobotProfile &profile)
 {
 	if (calcKShortestDistancePath(start, goalList, k, onlyUseFoundWall) == 0) return false;
-	std::vector<uint32_t> costs;
 
 	float minCost = FLT_MAX;
-	OperationList minCost_opList;
 	for (int i=k_shortestDistancePath.size()-1;i>=0;i--) {
-		minCost_opList.loadFromPath(k_shortestDistancePath[i], useDiagonalPath);
-		const float cost = minCost_opList.eval();
+		evalOperationList.loadFromPath(k_shortestDistancePath[i], useDiagonalPath);
+		if (profile.useLargeTurn()) evalOperationList.convertToLargeTurn();
+		const float cost = evalOperationList.eval(profile);
 		if (cost < minCost) {
 			minCost = cost;
-			shortestTimePath_operationList = minCost_opList;
+			shortestTimePath_operationList = evalOperationList;
 			shortestTimePath_index = i;
+			shortestTimePath = k_shortestDistancePath[i];
 		}
 	}
 	shortestTimePath_cost = minCost;
@@ -208,24 +450,435 @@ int ShortestPath::calcShortestTimePath(const IndexVec &start, const std::list<In
 	return true;
 }
 
-void ShortestPath::calcNeedToSearchWallIndex()
+template<int N>
+int ShortestPathT<N>::calcShortestTimePathByStateGraph(const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall, bool useDiagonalPath, const RobotProfile &profile)
+{
+	IndexList goalList;
+	goalList.push_back(goal);
+	return calcShortestTimePathByStateGraph(start, goalList, onlyUseFoundWall, useDiagonalPath, profile);
+}
+
+template<int N>
+float ShortestPathT<N>::calcStateCost(const IndexVec &start, const DistSet &goalSet, bool onlyUseFoundWall, bool useDiagonalPath,
+		const OperationCostTable &costTable, float limit, float margin, StateEdge &goalPrev)
+{
+	//各状態に入ってきた辺をstatePrevに覚えておき、最後にたどって経路を復元する
+	//辺のlengthは直線の区画数かターンの回数、turnはターンの列で最初に曲がった方向
+	std::vector<float> &cost = stateCost;
+	cost.assign(STATE_MAX, FLT_MAX);
+	statePrev.assign(STATE_MAX, StateEdge{-1, 0, TURN_ANY});
+	//ゴールは状態にせず、ゴールに入る辺だけを覚えておく
+	float goalCost = FLT_MAX;
+	goalPrev = StateEdge{-1, 0, TURN_ANY};
+
+	typedef std::pair<float, int> QueueItem;
+	std::vector<QueueItem> &q = stateQueue;
+	q.clear();
+	auto push = [&](const QueueItem &item) {
+		q.push_back(item);
+		std::push_heap(q.begin(), q.end(), std::greater<QueueItem>());
+	};
+
+	auto relax = [&](int from, int to, float newCost, int length, int turn) {
+		if (newCost >= cost[to]) return;
+		cost[to] = newCost;
+		statePrev[to] = StateEdge{from, (uint8_t)length, (uint8_t)turn};
+		push(QueueItem(newCost, to));
+	};
+	auto relaxGoal = [&](int from, float newCost, int length, int turn) {
+		if (newCost >= goalCost) return;
+		goalCost = newCost;
+		goalPrev = StateEdge{from, (uint8_t)length, (uint8_t)turn};
+	};
+
+	//スタートはロボットが北を向いていて、まだ何もしていない状態
+	if (goalSet.contains(start)) return FLT_MAX;
+	const int startState = stateIndex(0, start, 0, TURN_ANY);
+	cost[startState] = 0.0;
+	push(QueueItem(0.0, startState));
+
+	while (!q.empty()) {
+		std::pop_heap(q.begin(), q.end(), std::greater<QueueItem>());
+		const QueueItem top = q.back();
+		q.pop_back();
+		if (top.first > cost[top.second]) continue;
+		//コストは減らないので、これ以上短い時間でゴールに着くことはない
+		if (top.first >= goalCost && top.first >= std::min(limit, goalCost + margin)) break;
+
+		const int state = top.second;
+		const int turn = state%3;
+		const int dir = (state/3)%4;
+		const IndexVec index((state/12)%N, (state/(12*N))%N);
+		const int kind = state/(12*N*N);
+
+		if (kind == 0) {
+			//直線を進まずにそのままターンの列へ
+			//斜め走行なしの場合は交互ターンをまとめないので、どちらに曲がってもよい
+			const int nextTurn = useDiagonalPath ? turn : (int)TURN_ANY;
+			relax(state, stateIndex(1, index, dir, nextTurn), top.first, 0, TURN_ANY);
+
+			//直線をi区画進む
+			IndexVec cur = index;
+			for (int i=1;i<=N && canMoveOnStateGraph(cur, dir, onlyUseFoundWall);i++) {
+				cur = cur + IndexVec::vecDir[dir];
+				const float newCost = top.first + costTable.getForward(i);
+				if (goalSet.contains(cur)) {
+					relaxGoal(state, newCost, i, TURN_ANY);
+					break;
+				}
+				relax(state, stateIndex(1, cur, dir, TURN_ANY), newCost, i, TURN_ANY);
+			}
+		}
+		else {
+			//左右交互のターンをi回する
+			//斜め走行なしの場合は1回ずつ
+			const int maxTurn = useDiagonalPath ? UINT8_MAX : 1;
+			for (int firstTurn=TURN_RIGHT;firstTurn<=TURN_LEFT;firstTurn++) {
+				if (turn != TURN_ANY && turn != firstTurn) continue;
+
+				IndexVec cur = index;
+				int curDir = dir;
+				int curTurn = firstTurn;
+				for (int i=1;i<=maxTurn;i++) {
+					curDir = (curDir + (curTurn == TURN_RIGHT ? 1 : 3))%4;
+					if (!canMoveOnStateGraph(cur, curDir, onlyUseFoundWall)) break;
+					cur = cur + IndexVec::vecDir[curDir];
+
+					const float newCost = top.first + turnsCost(costTable, i);
+					if (goalSet.contains(cur)) {
+						relaxGoal(state, newCost, i, firstTurn);
+						break;
+					}
+					relax(state, stateIndex(0, cur, curDir, curTurn), newCost, i, firstTurn);
+					curTurn = (curTurn == TURN_RIGHT) ? TURN_LEFT : TURN_RIGHT;
+				}
+			}
+		}
+	}
+
+	return goalCost;
+}
+
+template<int N>
+void ShortestPathT<N>::calcStateCostToGoal(const DistSet &goalSet, bool useDiagonalPath, const OperationCostTable &costTable, float limit)
+{
+	std::vector<float> &cost = stateCostToGoal;
+	cost.assign(STATE_MAX, FLT_MAX);
+
+	typedef std::pair<float, int> QueueItem;
+	std::vector<QueueItem> &q = stateQueue;
+	q.clear();
+	//スタートからこの状態を通ってゴールに行く経路がlimit以上になる状態は、たどっても意味がない
+	//(stateCostにはcalcStateCostで計算したスタートからのコストが入っている)
+	auto relax = [&](int state, float newCost) {
+		if (newCost >= cost[state] || stateCost[state] >= limit - newCost) return;
+		cost[state] = newCost;
+		q.push_back(QueueItem(newCost, state));
+		std::push_heap(q.begin(), q.end(), std::greater<QueueItem>());
+	};
+
+	//toにdir方向へ直線をi区画進んで着く辺を、Aの状態まで逆にたどる
+	//辺の途中の区画がゴールだと、そこで辺が終わってしまう
+	auto relaxForward = [&](const IndexVec &to, int dir, float toCost) {
+		const int back = (dir+2)%4;
+		IndexVec cur = to;
+		for (int i=1;i<=N;i++) {
+			if (i > 1 && goalSet.contains(cur)) break;
+			if (!cur.canSum(IndexVec::vecDir[back], N)) break;
+			const IndexVec prev = cur + IndexVec::vecDir[back];
+			if (!canMoveOnStateGraph(prev, dir, false)) break;
+			for (int turn=TURN_ANY;turn<=TURN_LEFT;turn++) {
+				relax(stateIndex(0, prev, dir, turn), toCost + costTable.getForward(i));
+			}
+			cur = prev;
+		}
+	};
+	//toにdir方向を向いて、最後にlastTurnの方向に曲がって着く左右交互のターンi回の辺を、Bの状態まで逆にたどる
+	const int maxTurn = useDiagonalPath ? UINT8_MAX : 1;
+	auto relaxTurns = [&](const IndexVec &to, int dir, int lastTurn, float toCost) {
+		IndexVec cur = to;
+		int curDir = dir;
+		int curTurn = lastTurn;
+		for (int i=1;i<=maxTurn;i++) {
+			if (i > 1 && goalSet.contains(cur)) break;
+			const int back = (curDir+2)%4;
+			if (!cur.canSum(IndexVec::vecDir[back], N)) break;
+			const IndexVec prev = cur + IndexVec::vecDir[back];
+			if (!canMoveOnStateGraph(prev, curDir, false)) break;
+			//曲がる前の向き ここから始まる辺ではcurTurnが最初に曲がる方向
+			curDir = (curDir + (curTurn == TURN_RIGHT ? 3 : 1))%4;
+			relax(stateIndex(1, prev, curDir, TURN_ANY), toCost + turnsCost(costTable, i));
+			relax(stateIndex(1, prev, curDir, curTurn), toCost + turnsCost(costTable, i));
+			cur = prev;
+			curTurn = (curTurn == TURN_RIGHT) ? TURN_LEFT : TURN_RIGHT;
+		}
+	};
+
+	//ゴールに入る辺から始める
+	goalSet.forEach([&](const IndexVec &goal) {
+		for (int dir=0;dir<4;dir++) {
+			relaxForward(goal, dir, 0.0);
+			relaxTurns(goal, dir, TURN_RIGHT, 0.0);
+			relaxTurns(goal, dir, TURN_LEFT, 0.0);
+		}
+	});
+
+	while (!q.empty()) {
+		std::pop_heap(q.begin(), q.end(), std::greater<QueueItem>());
+		const QueueItem top = q.back();
+		q.pop_back();
+		if (top.first > cost[top.second]) continue;
+		if (top.first >= limit) break;
+
+		const int state = top.second;
+		const int turn = state%3;
+		const int dir = (state/3)%4;
+		const IndexVec index((state/12)%N, (state/(12*N))%N);
+		const int kind = state/(12*N*N);
+		//ゴールの区画にいる状態には、どの辺も入ってこない
+		if (goalSet.contains(index)) continue;
+
+		if (kind == 1) {
+			//直線を進まずにターンの列へ移る辺
+			if (useDiagonalPath) {
+				relax(stateIndex(0, index, dir, turn), top.first);
+			}
+			else if (turn == TURN_ANY) {
+				for (int prevTurn=TURN_ANY;prevTurn<=TURN_LEFT;prevTurn++) relax(stateIndex(0, index, dir, prevTurn), top.first);
+			}
+			//直線を進んだあとは、どちらに曲がってもよい
+			if (turn == TURN_ANY) relaxForward(index, dir, top.first);
+		}
+		else if (turn != TURN_ANY) {
+			relaxTurns(index, dir, turn, top.first);
+		}
+	}
+}
+
+template<int N>
+int ShortestPathT<N>::calcShortestTimePathByStateGraph(const IndexVec &start, const IndexList &goalList, bool onlyUseFoundWall, bool useDiagonalPath, const RobotProfile &profile)
+{
+	DistSet goalSet;
+	for (auto &goal : goalList) goalSet.set(goal);
+	StateEdge goalPrev;
+	calcStateCost(start, goalSet, onlyUseFoundWall, useDiagonalPath, profile.getCostTable(), 0.0, 0.0, goalPrev);
+	if (goalPrev.from < 0) return false;
+	const int startState = stateIndex(0, start, 0, TURN_ANY);
+
+	//ゴールからたどって辺を並べる
+	std::vector<StateEdge> &edges = stateEdge;
+	edges.clear();
+	edges.push_back(goalPrev);
+	for (int state = goalPrev.from; state != startState; state = statePrev[state].from) {
+		edges.push_back(statePrev[state]);
+	}
+	std::reverse(edges.begin(), edges.end());
+
+	//スタートから辺をなぞってPathとOperationListを作る
+	shortestTimePath.clear();
+	shortestTimePath_operationList.clear();
+	shortestTimePath.push_back(start);
+	for (const StateEdge &edge : edges) {
+		const int kind = edge.from/(12*N*N);
+		int curDir = (edge.from/3)%4;
+		if (edge.length == 0) continue;
+
+		if (kind == 0) {
+			shortestTimePath_operationList.push_back(Operation(Operation::FORWARD, edge.length));
+			for (int i=0;i<edge.length;i++) {
+				shortestTimePath.push_back(shortestTimePath.back() + IndexVec::vecDir[curDir]);
+			}
+		}
+		else {
+			int curTurn = edge.turn;
+			for (int i=0;i<edge.length;i++) {
+				curDir = (curDir + (curTurn == TURN_RIGHT ? 1 : 3))%4;
+				shortestTimePath.push_back(shortestTimePath.back() + IndexVec::vecDir[curDir]);
+				if (edge.length == 1) {
+					shortestTimePath_operationList.push_back(Operation(curTurn == TURN_RIGHT ? Operation::TURN_RIGHT90 : Operation::TURN_LEFT90));
+				}
+				curTurn = (curTurn == TURN_RIGHT) ? TURN_LEFT : TURN_RIGHT;
+			}
+
+			//斜めに入るときは最初に曲がった方向に45度、出るときは最後に曲がった方向に45度
+			if (edge.length > 1) {
+				const int lastTurn = (edge.length%2 == 1) ? (int)edge.turn : (int)(edge.turn == TURN_RIGHT ? TURN_LEFT : TURN_RIGHT);
+				shortestTimePath_operationList.push_back(Operation(edge.turn == TURN_RIGHT ? Operation::TURN_RIGHT45 : Operation::TURN_LEFT45));
+				if (edge.length > 2) {
+					shortestTimePath_operationList.push_back(Operation(Operation::FORWARD_DIAG, edge.length-2));
+				}
+				shortestTimePath_operationList.push_back(Operation(lastTurn == TURN_RIGHT ? Operation::TURN_RIGHT45 : Operation::TURN_LEFT45));
+			}
+		}
+	}
+	if (profile.useLargeTurn()) shortestTimePath_operationList.convertToLargeTurn();
+	shortestTimePath_cost = shortestTimePath_operationList.eval(profile);
+
+	return true;
+}
+
+template<int N>
+void ShortestPathT<N>::calcNeedToSearchWallIndex()
 {
 	//K shortest path上の未探索座標を列挙
 	needToSearchWallIndex.clear();
 	for (auto &path : k_shortestDistancePath) {
-		for (size_t i=0;i<path.size()-1;i++) {
-			IndexVec dxdy = path[i+1] - path[i];
-			for (int j=0;j<4;j++) {
-				if (dxdy == IndexVec::vecDir[j]) {
-					if (!maze->getWall(path[i])[j+4]) {
-						//唯一になるようにいれる
-						auto it = std::find(needToSearchWallIndex.begin(), needToSearchWallIndex.end(), path[i]);
-						if (it == needToSearchWallIndex.end()) {
-							needToSearchWallIndex.push_back(path[i]);
-						}
+		addNeedToSearchWallIndex(path);
+	}
+}
+
+template<int N>
+void ShortestPathT<N>::calcNeedToSearchWallIndex(const Path &path)
+{
+	needToSearchWallIndex.clear();
+	addNeedToSearchWallIndex(path);
+}
+
+template<int N>
+float ShortestPathT<N>::calcNeedToSearchWallIndexByTime(const IndexVec &start, const IndexList &goalList, float threshold, float margin,
+		bool useDiagonalPath, const RobotProfile &profile)
+{
+	const OperationCostTable &costTable = profile.getCostTable();
+	DistSet goalSet;
+	for (auto &goal : goalList) goalSet.set(goal);
+	StateEdge goalPrev;
+	const float knownCost = calcStateCost(start, goalSet, true, useDiagonalPath, costTable, 0.0, 0.0, goalPrev);
+
+	//未探索の壁は通れるとして、スタートからの前向きとゴールからの後ろ向きのコストを計算する
+	//辺u->vを通る経路の最小のコストは stateCost[u] + 辺のコスト + stateCostToGoal[v]
+	//knownCost-thresholdより速くならない壁は探索しなくてよく、楽観的な走行時間+marginより遅い壁は後回しにするので、
+	//コストがlimitより小さい状態だけ計算すればよい
+	wallCost.assign(N*N*4, FLT_MAX);
+	needToSearchWallIndex.clear();
+	needToSearchWallMask.assign(N*N, 0);
+	const float optimisticCost = calcStateCost(start, goalSet, false, useDiagonalPath, costTable, knownCost - threshold, margin, goalPrev);
+	if (optimisticCost >= knownCost - threshold) return knownCost;
+	//足す順番によって同じ経路のコストが少しずれるので、丸め誤差の分を足しておく
+	const float limit = std::min(knownCost - threshold, optimisticCost + margin + 1e-4f);
+	calcStateCostToGoal(goalSet, useDiagonalPath, costTable, limit);
+
+	//辺の区画ごとに、そこまでで辺を終えてゴールに向かう経路のコストをedgeCostに入れ、後ろから最小値をとる
+	//i番目の区画の移動は、i区画以上の長さの辺のどれでも通れるので、その最小値が壁を通る経路のコストになる
+	edgeCost.assign(UINT8_MAX+1, FLT_MAX);
+	auto updateWallCost = [&](const IndexVec &index, int dir, float cost) {
+		if (maze->getWall(index)[dir+4]) return;
+		const IndexVec neighbor = index + IndexVec::vecDir[dir];
+		float &c = wallCost[(index.y*N + index.x)*4 + dir];
+		float &d = wallCost[(neighbor.y*N + neighbor.x)*4 + (dir+2)%4];
+		if (cost < c) c = cost;
+		if (cost < d) d = cost;
+	};
+	auto toGoal = [&](const IndexVec &index, int state) {
+		return goalSet.contains(index) ? 0.0f : stateCostToGoal[state];
+	};
+	const int maxTurn = useDiagonalPath ? UINT8_MAX : 1;
+	for (int state=0;state<STATE_MAX;state++) {
+		const float cost = stateCost[state];
+		//この状態を通る経路がlimit以上なら、この状態から出る辺も調べなくてよい
+		if (cost >= limit || stateCostToGoal[state] >= limit - cost) continue;
+		const int turn = state%3;
+		const int dir = (state/3)%4;
+		const IndexVec index((state/12)%N, (state/(12*N))%N);
+		const int kind = state/(12*N*N);
+
+		if (kind == 0) {
+			int length = 0;
+			IndexVec cur = index;
+			for (int i=1;i<=N && canMoveOnStateGraph(cur, dir, false);i++) {
+				cur = cur + IndexVec::vecDir[dir];
+				edgeCost[i] = cost + costTable.getForward(i) + toGoal(cur, stateIndex(1, cur, dir, TURN_ANY));
+				length = i;
+				if (goalSet.contains(cur)) break;
+			}
+			for (int i=length-1;i>=1;i--) edgeCost[i] = std::min(edgeCost[i], edgeCost[i+1]);
+			cur = index;
+			for (int i=1;i<=length;i++) {
+				updateWallCost(cur, dir, edgeCost[i]);
+				cur = cur + IndexVec::vecDir[dir];
+			}
+			continue;
+		}
+
+		for (int firstTurn=TURN_RIGHT;firstTurn<=TURN_LEFT;firstTurn++) {
+			if (turn != TURN_ANY && turn != firstTurn) continue;
+
+			int length = 0;
+			IndexVec cur = index;
+			int curDir = dir;
+			int curTurn = firstTurn;
+			for (int i=1;i<=maxTurn;i++) {
+				curDir = (curDir + (curTurn == TURN_RIGHT ? 1 : 3))%4;
+				if (!canMoveOnStateGraph(cur, curDir, false)) break;
+				cur = cur + IndexVec::vecDir[curDir];
+				edgeCost[i] = cost + turnsCost(costTable, i) + toGoal(cur, stateIndex(0, cur, curDir, curTurn));
+				length = i;
+				if (goalSet.contains(cur)) break;
+				curTurn = (curTurn == TURN_RIGHT) ? TURN_LEFT : TURN_RIGHT;
+			}
+			for (int i=length-1;i>=1;i--) edgeCost[i] = std::min(edgeCost[i], edgeCost[i+1]);
+			cur = index;
+			curDir = dir;
+			curTurn = firstTurn;
+			for (int i=1;i<=length;i++) {
+				curDir = (curDir + (curTurn == TURN_RIGHT ? 1 : 3))%4;
+				updateWallCost(cur, curDir, edgeCost[i]);
+				cur = cur + IndexVec::vecDir[curDir];
+				curTurn = (curTurn == TURN_RIGHT) ? TURN_LEFT : TURN_RIGHT;
+			}
+		}
+	}
+
+	//limitより速く走れる経路の通る未探索の壁を、両側の区画から探索する
+	for (int y=0;y<N;y++) {
+		for (int x=0;x<N;x++) {
+			uint8_t &mask = needToSearchWallMask[y*N + x];
+			for (int dir=0;dir<4;dir++) {
+				if (wallCost[(y*N + x)*4 + dir] < limit) mask |= 1 << dir;
+			}
+			if (mask) needToSearchWallIndex.push_back(IndexVec(x, y));
+		}
+	}
+
+	return knownCost;
+}
+
+template<int N>
+void ShortestPathT<N>::retainNeedToSearchWallIndex()
+{
+	for (auto it = needToSearchWallIndex.begin();it != needToSearchWallIndex.end();) {
+		const Direction &wall = maze->getWall(*it);
+		const uint8_t mask = needToSearchWallMask[it->y*N + it->x];
+		bool found = true;
+		for (int dir=0;dir<4;dir++) {
+			if ((mask & (1 << dir)) && !wall[dir+4]) found = false;
+		}
+		if (found) {
+			it = needToSearchWallIndex.erase(it);
+			continue;
+		}
+		it++;
+	}
+}
+
+template<int N>
+void ShortestPathT<N>::addNeedToSearchWallIndex(const Path &path)
+{
+	for (size_t i=0;i+1<path.size();i++) {
+		IndexVec dxdy = path[i+1] - path[i];
+		for (int j=0;j<4;j++) {
+			if (dxdy == IndexVec::vecDir[j]) {
+				if (!maze->getWall(path[i])[j+4]) {
+					//唯一になるようにいれる
+					auto it = std::find(needToSearchWallIndex.begin(), needToSearchWallIndex.end(), path[i]);
+					if (it == needToSearchWallIndex.end()) {
+						needToSearchWallIndex.push_back(path[i]);
 					}
 				}
 			}
 		}
 	}
 }
+
+//使う大きさの迷路の実体をつくる
+template class ShortestPathT<16>;
+template class ShortestPathT<32>;
@@ -1,73 +1,261 @@
 #ifndef SHORTESTPATH_H_
 #define SHORTESTPATH_H_
 
-#include <list>
 #include <vector>
 
+#include "MazeSolver_conf.h"
 #include "Maze.h"
 #include "Operation.h"
 
-typedef std::vector<IndexVec> Path;
-
 
 /**************************************************************
- * ShortestPath
+ * ShortestPathT
  *	最短経路あたりのアルゴリズム
  *	・歩数マップによる最短経路の計算
  *	・Yes'sAlgorithmによるk最短経路の計算
+ *	  KSHORTEST_PATH_THREADSが2以上のときは、spur nodeごとの計算を複数のスレッドで行う
  *	・ロボットの走行パラメータに基づく経路走行時間の見積もり
+ *	・区画、向き、直前の動作を状態としたグラフ上での走行時間最短経路の計算
+ *	N:迷路の大きさ 普段はMAZE_SIZEの大きさのShortestPathを使う
  **************************************************************/
-class ShortestPath {
+template<int N>
+class ShortestPathT {
+public:
+	typedef PathT<N> Path;
+	typedef IndexListT<N> IndexList;
+
 private:
-	Maze *maze;
+	MazeT<N> *maze;
 
 	//色々と計算した経路を保存しとく
 	Path shortestDistancePath;
 	std::vector< Path > k_shortestDistancePath;
+	Path shortestTimePath;
 	int shortestTimePath_index;
 	OperationList shortestTimePath_operationList;
 	float shortestTimePath_cost;
-	std::list<IndexVec> needToSearchWallIndex;
+	IndexList needToSearchWallIndex;
 
 	//k shortest pathの関数内で使う
-	void removeEdge(const IndexVec& start, const IndexVec& end);
-	void removeNode(const IndexVec& node);
-	bool matchPath(const Path &path1, const Path &path2, int n);
+	bool matchPath(const Path &path1, const Path &path2, size_t n);
+
+	/**************************************************************
+	 * RemovedWall
+	 *	k shortest pathの計算中に一時的に足した壁
+	 *	mazeの壁情報とORをとったものを壁として扱う
+	 *	書き換えた座標を覚えておき、restoreでそこだけ0に戻す
+	 **************************************************************/
+	struct RemovedWall {
+		uint8_t wall[N][N];
+		IndexList index;
+
+		RemovedWall()
+		{
+			for (int i=0;i<N;i++) {
+				for (int j=0;j<N;j++) {
+					wall[i][j] = 0;
+				}
+			}
+		}
+
+		//Maze::updateWall(cur, newState)と同じように壁を足す
+		void add(const IndexVec& cur, const Direction& newState);
+		void restore();
+	};
+
+	/**************************************************************
+	 * SpurWorker
+	 *	1つのspur nodeからの経路を計算するのに使う作業領域
+	 *	スレッドごとに1つ持ち、mazeは書き換えずに読むだけにする
+	 *	removeEdgeで消した辺は毎回戻すが、removeNodeで消した頂点はrootPathが伸びるごとに足していく
+	 **************************************************************/
+	struct SpurWorker {
+		RemovedWall removedEdge;
+		RemovedWall removedNode;
+		//removedNodeに入れた、1つ前のk shortest path上の頂点の数
+		size_t nRemovedNode;
+		Path spurPath;
+
+		SpurWorker() : nRemovedNode(0) {}
+		void restore()
+		{
+			removedEdge.restore();
+			removedNode.restore();
+			nRemovedNode = 0;
+		}
+	};
+	SpurWorker spurWorker[KSHORTEST_PATH_THREADS];
+
+	//removeEdge,removeNodeはmazeを書き換えずに、workerのremovedEdge,removedNodeに壁を足したことにする
+	void removeEdge(SpurWorker &worker, const IndexVec& start, const IndexVec& end);
+	void removeNode(SpurWorker &worker, const IndexVec& node);
+	inline Direction getWallWithRemoved(const SpurWorker &worker, const IndexVec& index) const
+	{
+		return Direction(maze->getWall(index) | worker.removedEdge.wall[index.y][index.x] | worker.removedNode.wall[index.y][index.x]);
+	}
+
+	//workerの壁を考慮してstartからgoalへの最短経路を計算し、worker.spurPathに格納する
+	//mazeの歩数マップは使わずに、startに歩数が届いたところで計算をやめる
+	int calcSpurPath(SpurWorker &worker, const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall);
+
+	/**************************************************************
+	 * PathCandidate
+	 *	k shortest pathの候補(B)
+	 *	経路の長さ、同じ長さの場合はBに入れた順で並べる
+	 **************************************************************/
+	struct PathCandidate {
+		size_t length;
+		uint32_t order;
+		Path path;
+
+		PathCandidate(size_t _length, uint32_t _order, const Path &_path) : length(_length), order(_order), path(_path) {}
+		bool operator>(const PathCandidate &rhs) const
+		{
+			if (length != rhs.length) return length > rhs.length;
+			return order > rhs.order;
+		}
+	};
+
+	//k shortest pathの関数内で使う作業領域
+	//呼び出すたびにヒープから確保しないように持っておき、中身だけ空にして使いまわす
+	//candidate:spur nodeごとの経路
+	//B:候補のheap
+	//pathHash:一度Bに入れた経路とk_shortestDistancePathの経路のハッシュのオープンアドレス法のハッシュ表(0は空き)
+	std::vector<Path> candidate;
+	std::vector<PathCandidate> B;
+	std::vector<uint64_t> pathHash;
+	size_t nPathHash;
+	//pathHashに入れる 既に入っていた場合はfalseを返す
+	bool insertPathHash(uint64_t hash);
+
+	/**************************************************************
+	 * 走行時間のグラフ(calcShortestTimePathByStateGraph, calcNeedToSearchWallIndexByTime)
+	 *	OperationList::loadFromPathでPathがどういうOperationになるかをそのまま状態にする
+	 *	・進む方向が変わらない移動はFORWARDになり、続くFORWARDはまとめられる
+	 *	・進む方向が変わる移動はTURN_RIGHT90かTURN_LEFT90になる(区画の移動も含む)
+	 *	・斜め走行ありの場合、左右交互のターンがL回続くと45度ターン2回とFORWARD_DIAG(L-2)になる
+	 *	なので直線1本、交互ターンの列1つを辺とし、その間の区切りを頂点とする
+	 *	  A(kind=0):ターンの列を終えたところ(スタート地点もここ) 次は直線を0区画以上進む
+	 *	  B(kind=1):直線を進み終えたところ 次はターンの列をする
+	 *	直線を0区画進んでターンの列を続ける場合、逆向きに曲がると前の列とつながってしまうので
+	 *	Aは最後に曲がった方向を、Bは次に曲がってよい方向を持つ
+	 *	ゴールは状態にせず、ゴールの区画に入ったところで辺が終わる
+	 **************************************************************/
+	enum { TURN_ANY = 0, TURN_RIGHT = 1, TURN_LEFT = 2 };
+	enum { STATE_MAX = 2*N*N*4*3 };
+	static inline int stateIndex(int kind, const IndexVec &index, int dir, int turn)
+	{
+		return (((kind*N + index.y)*N + index.x)*4 + dir)*3 + turn;
+	}
+	//直線、斜め直線の距離ごとのコストはOperationCostTableの表を引く
+	//Operation::nがuint8_tなので、交互ターンの列はUINT8_MAX回まで
+	static inline float turnsCost(const OperationCostTable &costTable, int nTurn)
+	{
+		if (nTurn == 1) return costTable.getTurn90();
+		return 2*costTable.getTurn45() + costTable.getForwardDiag(nTurn-2);
+	}
+	inline bool canMoveOnStateGraph(const IndexVec &index, int dir, bool onlyUseFoundWall) const
+	{
+		const Direction &wall = maze->getWall(index);
+		if (wall[dir]) return false;
+		if (onlyUseFoundWall && !wall[dir+4]) return false;
+		return index.canSum(IndexVec::vecDir[dir], N);
+	}
+	typedef typename MazeT<N>::DistSet DistSet;
+
+	//状態ごとのコストと入ってきた辺、ゴールまでのコスト、ダイクストラ法のheap、経路を復元するときの辺の並び
+	struct StateEdge {
+		int from;
+		uint8_t length;
+		uint8_t turn;
+	};
+	std::vector<float> stateCost;
+	std::vector<StateEdge> statePrev;
+	std::vector<float> stateCostToGoal;
+	std::vector< std::pair<float, int> > stateQueue;
+	std::vector<StateEdge> stateEdge;
+
+	//startから各状態へのコストをstateCostに、入ってきた辺をstatePrevに、ゴールに入る辺をgoalPrevに入れ、ゴールまでのコストを返す
+	//ゴールに着けない場合はFLT_MAXを返し、goalPrev.fromは-1になる
+	//ゴールに着いても、コストがmin(limit, ゴールまでのコスト+margin)より小さい状態は全て計算する
+	float calcStateCost(const IndexVec &start, const DistSet &goalSet, bool onlyUseFoundWall, bool useDiagonalPath,
+			const OperationCostTable &costTable, float limit, float margin, StateEdge &goalPrev);
+	//辺を逆向きにたどって、各状態からゴールまでのコストをstateCostToGoalに入れる(未探索の壁は通れるものとする)
+	//コストがlimit以上の状態は計算しない
+	void calcStateCostToGoal(const DistSet &goalSet, bool useDiagonalPath, const OperationCostTable &costTable, float limit);
+
+	//calcNeedToSearchWallIndexByTimeで使う
+	//wallCost:区画と方向ごとに、その壁を通る経路のコストの最小値
+	//edgeCost:1つの辺の区画ごとのコスト
+	//needToSearchWallMask:区画ごとの探索すべき壁(下位4bit)
+	std::vector<float> wallCost;
+	std::vector<float> edgeCost;
+	std::vector<uint8_t> needToSearchWallMask;
+
+	//calcShortestTimePathで経路を変換するのに使う
+	OperationList evalOperationList;
+
+	//pathの上の未探索壁がある座標をneedToSearchWallIndexに足す(同じ座標は1つだけ)
+	void addNeedToSearchWallIndex(const Path &path);
+
+	//1つ前のk shortest path(k_shortestDistancePath.back())のi番目の頂点をspur nodeとしたときの経路をcandidateに入れる
+	//経路がない場合はcandidateを空にする
+	//同じworkerではiを増やす順に呼ぶ
+	void calcSpurCandidate(SpurWorker &worker, size_t i, bool onlyUseFoundWall, Path &candidate);
 
 public:
-	ShortestPath(Maze &_maze, bool _useDiagonalPath = false)
-: maze(&_maze), shortestTimePath_index(-1)
+	ShortestPathT(MazeT<N> &_maze, bool _useDiagonalPath = false)
+: maze(&_maze), shortestTimePath_index(-1), nPathHash(0)
 {
 		clear();
 }
 
 	void clear() {
 		shortestDistancePath.clear();
+		shortestTimePath.clear();
 		needToSearchWallIndex.clear();
 		shortestTimePath_index=-1;
 	}
 
 	//startからgoalへの最短経路を計算し、shortestDistancePathに格納する
 	//goalListを与えた場合、goalListに含まれる座標のうち一番近い座標への道のりを計算する
+	//goalListの全ての座標を歩数0にした歩数マップを1回計算して、startから下るだけ
 	//onlyUseFoundWall=trueのとき、未探索壁を通らない経路を生成する
 	int calcShortestDistancePath(const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall);
-	int calcShortestDistancePath(const IndexVec &start, const std::list<IndexVec> &goalList, bool onlyUseFoundWall);
+	int calcShortestDistancePath(const IndexVec &start, const IndexList &goalList, bool onlyUseFoundWall);
 	inline const Path &getShortestDistancePath() const { return shortestDistancePath; }
 
 	//k最短経路を計算する
 	//calcShortestDistancePathと振る舞いは同じ
 	//結果はk_shortestDistancePathに格納
 	int calcKShortestDistancePath(const IndexVec &start, const IndexVec &goal, int k, bool onlyUseFoundWall);
-	int calcKShortestDistancePath(const IndexVec &start, const std::list<IndexVec> &goalList, int k, bool onlyUseFoundWall);
+	int calcKShortestDistancePath(const IndexVec &start, const IndexList &goalList, int k, bool onlyUseFoundWall);
 	inline const std::vector< Path > &getKShortestDistancePath() const { return k_shortestDistancePath; }
 
 	//時間に関して最短(だろう)経路を計算する
 	//内部でk_shortestDistancePathを実行し、k個のpathの走行時間を計算する
 	//その内で一番コスト(走行時間)が小さいものをShortestTimePathとする
 	//最短経路のindex(k_shortestDistancePathの)をshortestTimePath_indexに格納する
-	int calcShortestTimePath(const IndexVec &start, const IndexVec &goal, int k, bool onlyUseFoundWall, bool useDiagonalPath);
-	int calcShortestTimePath(const IndexVec &start, const std::list<IndexVec> &goalList, int k, bool onlyUseFoundWall, bool useDiagonalPath);
-	inline const Path &getShortestTimePath() const { return k_shortestDistancePath[shortestTimePath_index]; }
+	//走行時間はprofileの走行性能で計算する
+	//profile.useLargeTurn()の場合は大回りのターンに変換してから走行時間を計算する
+	int calcShortestTimePath(const IndexVec &start, const IndexVec &goal, int k, bool onlyUseFoundWall, bool useDiagonalPath,
+			const RobotProfile &profile = RobotProfile::getDefault());
+	int calcShortestTimePath(const IndexVec &start, const IndexList &goalList, int k, bool onlyUseFoundWall, bool useDiagonalPath,
+			const RobotProfile &profile = RobotProfile::getDefault());
+
+	//走行時間が最短の経路を、k最短経路を経由せずに直接計算する
+	//状態を(区画, 向き, 直前の曲がり方)としたグラフの上でダイクストラ法を行う
+	//辺は「直線をn区画進む」「左右交互の連続ターンをn回する」の単位で、コストはprofileの表を引く
+	//profileでターンの速度を指定していても辺のコストは表で計算する(getShortestTimePathCostは速度を持ち越すモデルのコスト)
+	//速度を持ち越すモデルで経路を選ぶ場合はcalcShortestTimePathを使う
+	//大回りのターンも辺のコストには入れず、経路が決まってから変換する
+	//calcShortestTimePathと同じくgetShortestTimePath, getShortestTimePathOperation, getShortestTimePathCostで結果を取得する
+	//k_shortestDistancePathとshortestTimePath_indexは変更しない
+	int calcShortestTimePathByStateGraph(const IndexVec &start, const IndexVec &goal, bool onlyUseFoundWall, bool useDiagonalPath,
+			const RobotProfile &profile = RobotProfile::getDefault());
+	int calcShortestTimePathByStateGraph(const IndexVec &start, const IndexList &goalList, bool onlyUseFoundWall, bool useDiagonalPath,
+			const RobotProfile &profile = RobotProfile::getDefault());
+	inline const Path &getShortestTimePath() const { return shortestTimePath; }
 	inline const OperationList &getShortestTimePathOperation() const { return shortestTimePath_operationList; }
 	inline float getShortestTimePathCost() const { return shortestTimePath_cost; }
 
@@ -75,8 +263,25 @@ public:
 	//この座標が追加で探索すべき座標になる
 	//calcKShortestDistancePathを実行してから実行する
 	void calcNeedToSearchWallIndex();
-	inline const std::list<IndexVec> &getNeedToSearchIndex() const { return needToSearchWallIndex; }
+	//pathの上の未探索壁がある座標リストを計算する(getShortestTimePathで取った経路など)
+	void calcNeedToSearchWallIndex(const Path &path);
+	//未探索の壁ごとに、その壁を通ってstartからgoalListに行く経路の走行時間の最小値(ほかの未探索の壁は通れるものとする)を計算し、
+	//今わかっている壁だけで走れる経路の走行時間よりthreshold[s]以上短くなる壁を探索すべき壁とする
+	//そのうち、未探索の壁を全て通れるとしたときの最短の走行時間からmargin[s]以内の経路が通る壁の両側の座標を、座標リストに入れる
+	//(marginを大きくすると、探索すべき壁を全て座標リストに入れる)
+	//今わかっている壁だけで走れる経路の走行時間を返す(経路がなければFLT_MAX)
+	//走行時間はcalcShortestTimePathByStateGraphの辺のコストで数える
+	float calcNeedToSearchWallIndexByTime(const IndexVec &start, const IndexList &goalList, float threshold, float margin, bool useDiagonalPath,
+			const RobotProfile &profile = RobotProfile::getDefault());
+	//calcNeedToSearchWallIndexByTimeのあとで、探索すべき壁が全てわかった座標を座標リストから除く
+	void retainNeedToSearchWallIndex();
+	//calcNeedToSearchWallIndexByTimeで計算した、indexのdir方向の壁を通る経路の走行時間の最小値
+	//座標リストに入れなかった壁は、計算を打ち切るので正確な値にならない(FLT_MAXのこともある)
+	inline float getCostThroughWall(const IndexVec &index, int dir) const { return wallCost[(index.y*N + index.x)*4 + dir]; }
+	inline const IndexList &getNeedToSearchIndex() const { return needToSearchWallIndex; }
 };
 
+typedef ShortestPathT<MAZE_SIZE> ShortestPath;
+
 
 #endif /* SHORTESTPATH_H_ */
@@ -1,19 +1,262 @@
 #ifndef MAZEDATA_H_
 #define MAZEDATA_H_
 
-#include "Maze.h"
-
-extern const char mazeData_maze2011exp[16+1][16+1];
-extern const char mazeData_maze2011fr[16+1][16+1];
-extern const char mazeData_maze2012exp[16+1][16+1];
-extern const char mazeData_maze2013exp[16+1][16+1];
-extern const char mazeData_maze2013fr[16+1][16+1];
-extern const char mazeData_maze2013taiwan[16+1][16+1];
-extern const char mazeData_maze2[16+1][16+1];
-extern const char mazeData_maze3[16+1][16+1];
-extern const char mazeData_maze4[16+1][16+1];
-extern const char mazeData_maze5[16+1][16+1];
-extern const char mazeData_maze[16+1][16+1];
-extern const char mazeData_66test[5+1][5+1];
+#include "MazeImage.h"
+
+//迷路ファイル(maze_data/*.dat)の中身をそのまま貼り付けて、コンパイル時に壁情報の表にしておく
+//迷路を追加するときは、Maze::saveToFileで保存したファイルの中身をR"(の直後から貼り付けてstatic_assertを足す
+
+constexpr MazeImageT<16> mazeData_maze2011exp = parseMazeImage<16>(R"(0
+16
+16
+9 5 5 5 5 5 1 1 5 5 5 1 1 1 1 3
+8 3 9 1 5 7 a 8 3 9 3 e e a a a
+a a a c 5 3 8 2 8 6 8 1 5 0 2 a
+a a c 1 7 a a 8 6 9 6 8 1 6 a a
+a 8 7 a d 2 c 4 5 6 9 2 a 9 6 a
+c 0 7 c 3 e 9 5 5 1 2 a 8 6 9 6
+d 0 5 5 6 9 4 5 5 2 c 0 2 d 2 f
+d 0 7 9 3 8 3 9 3 e 9 2 e d 4 3
+d 0 7 a a a a 8 6 9 2 e 9 3 9 2
+b c 3 a a c 0 6 9 2 e 9 2 c 6 a
+a d 4 2 8 3 c 5 6 e 9 2 e d 5 2
+a 9 7 c 2 a b b 9 3 a a 9 1 5 2
+a 8 7 9 2 c 2 a a c 6 8 2 e d 2
+8 6 9 6 a b 8 6 a b 9 6 c 3 d 2
+8 1 4 7 a a a 9 6 a c 3 9 4 1 6
+e c 5 5 4 4 4 4 5 4 5 4 4 5 4 7
+)");
+static_assert(mazeData_maze2011exp.isValid(), "mazeData_maze2011exp is broken");
+
+constexpr MazeImageT<16> mazeData_maze2011fr = parseMazeImage<16>(R"(0
+16
+16
+9 5 5 5 1 5 5 5 1 1 5 1 5 1 5 3
+a b d 3 a 9 5 3 a a b a f c 3 a
+a a d 6 a a b a a a e 8 5 3 a a
+c 4 5 3 a a a a a c 7 c 7 a c 2
+f d 3 a a a a a 8 5 7 9 7 8 3 a
+f d 6 a a a e a a 9 5 0 3 a 8 2
+d 5 1 6 c 6 9 6 e a b a a a a a
+9 5 2 9 5 5 6 9 1 2 a a 8 2 a a
+c 5 2 8 1 5 3 c 6 a a a a a a a
+9 5 4 2 a b 8 1 3 a e a a a a a
+e 9 5 2 a a a a a c 5 2 e a a a
+f c 5 2 a a a a 8 5 7 c 5 4 6 a
+9 5 1 6 a a a a a 9 5 1 7 b b a
+a b a b a c 4 2 8 2 b 8 5 6 8 2
+a a c 2 a 9 5 6 a a e a f 9 6 a
+e c 5 4 4 4 5 5 6 c 5 4 5 6 f e
+)");
+static_assert(mazeData_maze2011fr.isValid(), "mazeData_maze2011fr is broken");
+
+constexpr MazeImageT<16> mazeData_maze2012exp = parseMazeImage<16>(R"(0
+16
+16
+9 3 9 5 5 5 1 5 5 5 5 3 9 3 9 3
+a a a 9 3 9 6 9 5 5 5 6 a a a a
+a c 6 a 8 4 7 c 5 5 5 3 a c 6 a
+8 5 5 6 a 9 5 5 5 5 5 2 c 5 3 a
+a 9 5 1 6 a 9 1 5 3 9 6 9 5 2 a
+8 6 9 6 b a a 8 3 a c 3 a 9 6 a
+a 9 4 5 2 a 8 2 e a 9 6 8 4 3 a
+8 6 9 5 2 a a 8 3 a a 9 4 1 6 a
+8 1 4 3 a a a 8 6 a 8 6 9 4 7 a
+a c 3 c 2 a a 8 3 c 6 9 4 7 b a
+c 5 4 5 2 8 2 a a 9 5 2 d 1 2 a
+9 5 5 5 2 a a 8 2 8 5 6 9 6 a a
+c 5 3 d 2 c 4 2 c 2 9 3 a 9 6 a
+9 3 8 3 8 5 3 c 5 6 a a a 8 5 6
+a a a a a d 4 5 5 5 6 c 6 c 5 3
+e c 6 c 4 5 5 5 5 5 5 5 5 5 5 6
+)");
+static_assert(mazeData_maze2012exp.isValid(), "mazeData_maze2012exp is broken");
+
+constexpr MazeImageT<16> mazeData_maze2013exp = parseMazeImage<16>(R"(0
+16
+16
+9 7 9 5 5 5 5 5 5 5 5 5 1 3 9 3
+8 5 6 9 1 5 5 5 5 5 5 3 e a a a
+8 7 9 6 a 9 5 1 5 3 d 4 3 c 6 a
+a d 0 5 6 a d 0 7 a 9 3 8 5 3 a
+a d 0 7 9 6 d 0 7 c 6 a a d 2 a
+a 9 4 3 c 3 d 0 7 9 3 a c 3 a a
+a 8 5 4 3 a d 0 5 6 a c 3 a a a
+a c 5 3 a c 3 8 3 9 6 b a a a a
+a 9 5 6 a 9 6 c 6 c 3 c 2 a a a
+a c 5 3 c 4 3 9 3 9 6 9 6 a a a
+a 9 5 6 9 3 c 6 c 6 b a d 2 a a
+a 8 5 5 6 a 9 1 5 3 c 2 9 6 a a
+a 8 3 9 3 c 6 c 5 2 9 6 a b a a
+a a c 6 8 1 7 9 3 c 4 3 a 8 6 a
+a a b b e c 5 6 c 5 5 4 6 a d 2
+e c 4 4 5 5 5 5 5 5 5 5 5 4 5 6
+)");
+static_assert(mazeData_maze2013exp.isValid(), "mazeData_maze2013exp is broken");
+
+constexpr MazeImageT<16> mazeData_maze2013fr = parseMazeImage<16>(R"(0
+16
+16
+9 1 1 5 1 5 1 5 5 3 f f 9 1 1 3
+a a a f a f a f 9 4 5 5 6 a a a
+a 8 6 9 6 f a f a 9 5 5 5 6 a a
+8 2 f a d 5 4 3 a a 9 5 5 5 6 a
+a a 9 2 f f f a c 6 c 5 5 3 9 2
+a 8 6 8 1 5 1 6 f 9 5 5 5 6 a a
+c 2 f a a f a 9 5 4 5 5 3 f a a
+f 8 1 6 a f a 8 3 9 5 3 a f a a
+f a c 3 8 5 6 c 6 a f a a f a a
+9 2 f a c 5 5 5 3 c 3 a c 5 6 a
+a c 5 4 5 3 9 5 4 3 a c 5 5 5 2
+a f f f f a a 9 3 a a f 9 5 5 2
+8 5 1 5 5 4 2 a a c 6 9 6 9 5 2
+a f 8 5 1 5 4 6 c 3 f a f a f a
+a f a f a f 9 5 5 2 f a f a f a
+e f c 5 4 5 6 f f c 5 4 5 4 5 6
+)");
+static_assert(mazeData_maze2013fr.isValid(), "mazeData_maze2013fr is broken");
+
+constexpr MazeImageT<16> mazeData_maze2013taiwan = parseMazeImage<16>(R"(0
+16
+16
+9 3 b 9 1 1 3 b 9 3 b 9 3 b 9 3
+a 8 0 2 a a 8 2 a 8 2 a a 8 2 a
+a e e c 4 4 6 c 6 e c 6 c 6 e a
+8 5 1 5 1 7 9 5 3 9 1 1 3 9 1 6
+8 5 0 5 6 9 6 9 6 a a a 8 6 8 7
+c 1 4 7 9 6 9 4 7 c 2 8 2 9 4 3
+9 4 7 9 6 9 6 d 5 5 0 6 a 8 5 2
+8 7 9 6 9 6 b 9 1 5 4 5 6 c 1 6
+a 9 6 9 6 9 2 c 6 b 9 1 3 d 0 7
+8 6 9 6 9 6 a d 1 4 6 e c 5 4 7
+e 9 6 9 6 9 6 d 4 3 9 3 9 3 9 3
+9 6 9 6 9 6 9 5 3 c 6 c 6 c 6 a
+c 5 6 9 6 9 6 9 6 9 5 3 d 1 3 a
+b 9 5 6 9 6 9 6 9 6 9 6 9 6 a a
+8 2 9 1 6 9 6 9 6 9 6 9 6 9 6 a
+e c 6 c 7 c 5 6 d 4 5 6 d 4 5 6
+)");
+static_assert(mazeData_maze2013taiwan.isValid(), "mazeData_maze2013taiwan is broken");
+
+constexpr MazeImageT<16> mazeData_maze2 = parseMazeImage<16>(R"(0
+16
+16
+9 5 5 1 5 5 3 f f 9 5 5 1 5 5 3
+a f 9 2 f f c 5 5 6 f f a f f a
+a 9 6 a f f 9 3 9 5 5 3 a f f a
+8 4 5 2 f f a a a 9 5 6 8 5 5 2
+a f f c 5 3 a a a a 9 5 6 9 3 a
+e f f f f 8 6 c 6 c 2 f f a a a
+9 3 9 5 5 6 9 5 5 3 c 1 5 2 8 6
+a a a f f f 8 1 3 a d 4 3 a a f
+a a a f f f a c 6 8 5 5 6 a a f
+a 8 4 1 5 3 c 5 5 6 d 5 5 6 c 3
+a e 9 6 f a b f f 9 3 f f f f a
+a 9 6 d 7 a a f f a c 5 3 f f a
+8 6 9 5 5 6 a f f a f f 8 5 5 2
+a b a f f f c 5 5 6 f f a f f a
+a a a d 5 1 5 1 5 3 f f a f f a
+e e c 5 5 4 5 6 f c 5 5 4 5 5 6
+)");
+static_assert(mazeData_maze2.isValid(), "mazeData_maze2 is broken");
+
+constexpr MazeImageT<16> mazeData_maze3 = parseMazeImage<16>(R"(0
+16
+16
+d 5 5 5 3 f f f f f f f f f f f
+d 5 1 1 6 f f f 9 3 f f f f f f
+f f e 8 1 5 5 5 6 a f f f f f f
+f f f e a f 9 3 f a 9 3 f f f f
+f f 9 5 0 5 2 a f a a a f f f f
+f f c 5 2 b a a 9 6 a a f f f f
+f f 9 5 6 c 6 c 0 5 6 c 5 5 5 3
+9 5 0 7 f f f 9 2 f f f f f f a
+a 9 6 f 9 5 5 4 4 3 f f f f f a
+a a f b a f f f f 8 5 5 3 f f a
+a e f 8 6 f f f f a f f c 1 5 6
+c 5 3 a f f f f f a f f f a f f
+b 9 6 a 9 5 5 5 5 2 f f f a f f
+8 6 b e e f b f f a f f f a f f
+8 5 4 5 1 5 6 f f c 5 5 5 6 f b
+e f f f e f f f f f f f f f f e
+)");
+static_assert(mazeData_maze3.isValid(), "mazeData_maze3 is broken");
+
+constexpr MazeImageT<16> mazeData_maze4 = parseMazeImage<16>(R"(0
+16
+16
+d 5 1 1 5 7 f 9 5 1 5 5 5 7 d 3
+9 7 a c 5 5 5 2 f c 5 5 1 5 3 a
+a f a f f 9 7 a d 1 5 3 a f a a
+c 5 4 1 3 c 5 2 f a d 6 c 3 c 2
+f b f a a b b c 5 6 f 9 5 6 f a
+d 4 5 2 a c 0 5 3 f f a f 9 5 6
+d 1 3 a a d 6 f 8 1 5 6 d 4 5 3
+f a a c 2 d 3 9 2 c 3 9 5 1 7 a
+f c 4 3 a f a c 4 7 a e f a f a
+9 3 b c 4 3 a f 9 3 8 3 f a 9 6
+a a c 5 5 2 c 5 6 c 6 a 9 4 6 b
+a c 5 5 3 c 5 5 5 5 5 6 8 5 5 2
+a f f f a b f f b 9 5 5 6 f b a
+a f f d 0 4 1 5 4 6 9 5 5 1 2 a
+8 3 9 3 8 5 0 1 5 5 2 f f e e a
+e c 6 c 6 f e e f f c 5 5 5 5 6
+)");
+static_assert(mazeData_maze4.isValid(), "mazeData_maze4 is broken");
+
+constexpr MazeImageT<16> mazeData_maze5 = parseMazeImage<16>(R"(0
+16
+16
+f 9 3 f 9 5 3 b f d 3 9 7 d 5 3
+d 4 6 b 8 5 2 e d 1 4 6 f b b e
+f 9 3 c 4 5 0 7 b a b b d 0 2 b
+f e e f 9 7 e d 6 a 8 0 7 e 8 6
+d 1 7 b e 9 7 d 5 4 6 c 3 d 6 f
+f e b c 3 8 3 b 9 1 1 7 c 5 7 f
+d 5 2 d 2 e e a 8 6 c 7 f d 1 3
+f f e 9 4 1 5 0 2 d 5 7 d 5 0 6
+d 7 9 6 f c 3 c 2 b d 1 5 1 0 7
+f 9 2 b 9 7 c 5 2 e d 4 7 e c 7
+d 2 c 4 4 1 7 d 6 9 3 f b b f f
+d 4 5 1 7 a d 3 9 2 c 7 e a b b
+f b b c 1 4 5 6 c 6 f f 9 4 0 6
+9 4 4 3 a d 1 3 d 7 9 5 4 5 6 f
+a f 9 4 2 f a a 9 1 4 5 5 3 b f
+e f e d 6 f e e e c 5 5 5 4 6 f
+)");
+static_assert(mazeData_maze5.isValid(), "mazeData_maze5 is broken");
+
+constexpr MazeImageT<16> mazeData_maze = parseMazeImage<16>(R"(0
+16
+16
+9 5 5 1 5 5 3 f f 9 5 5 1 5 5 3
+a f 9 2 f f c 5 5 6 f f a f f a
+a 9 6 a f f 9 3 9 5 5 3 a f f a
+8 4 5 2 f f a a a 9 5 6 8 5 5 2
+a f f c 5 3 a a a a 9 5 6 9 3 a
+e f f f f 8 6 c 6 c 2 f f a a a
+9 3 9 5 5 6 9 5 5 3 c 1 5 2 8 6
+a a a f f f 8 1 3 a d 4 3 a a f
+a a e f f f a c 6 8 5 5 6 a a f
+a 8 5 1 5 3 c 5 5 6 d 5 5 6 c 3
+a e 9 6 f a b f f 9 3 f f f f a
+a 9 6 d 7 a a f f a c 5 3 f f a
+8 6 9 5 5 6 a f f a f f 8 5 5 2
+a b a f f f c 5 5 6 f f a f f a
+a a a d 5 1 5 1 5 3 f f a f f a
+e e c 5 5 4 5 6 f c 5 5 4 5 5 6
+)");
+static_assert(mazeData_maze.isValid(), "mazeData_maze is broken");
+
+constexpr MazeImageT<5> mazeData_66test = parseMazeImage<5>(R"(0
+5
+5
+9 1 5 1 3
+a a d 6 a
+a a d 3 a
+a a f a a
+e c 5 4 6
+)");
+static_assert(mazeData_66test.isValid(), "mazeData_66test is broken");
 
 #endif /* MAZEDATA_H_ */
@@ -1,17 +1,42 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
 
 #include <list>
 #include <vector>
+#include <new>
 #include <unistd.h>
+#include <chrono>
 
 #include "MazeSolver_conf.h"
 #include "Maze.h"
 #include "mazeData.h"
 #include "ShortestPath.h"
 #include "Agent.h"
+#include "DistanceOracle.h"
+#include "SearchTour.h"
+#include "Profiler.h"
+#include "MazeGenerator.h"
+#include "MazeCorpus.h"
 
 
+//test_Allocationで使う
+//ヒープを確保した回数を数える
+static size_t nAllocation = 0;
+void *operator new(size_t size)
+{
+	nAllocation++;
+	void *p = malloc(size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
 void test_Size()
 {
 	printf("%lu \n", sizeof(Direction)); //1
@@ -26,15 +51,94 @@ void test_Maze(const char *filename)
 {
 	Maze field;
 	field.loadFromFile(filename);
-	//field.loadFromArray(mazeData_66test);
+	//field.loadFromImage(mazeData_66test);
 	field.printWall();
 }
 
+void test_StepMapRepair(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	//1区画ずつ壁情報を入れていき、差分更新した歩数マップと全体を計算しなおしたものを比べる
+	Maze mazeInRobot;
+	const IndexVec goal(7,7);
+	int nMismatch = 0;
+	for (int onlyUseFoundWall=0;onlyUseFoundWall<2;onlyUseFoundWall++) {
+		mazeInRobot.clear();
+		for (int i=0;i<MAZE_SIZE*MAZE_SIZE;i++) {
+			const int n = (i*7)%(MAZE_SIZE*MAZE_SIZE);
+			const IndexVec cur(n%MAZE_SIZE, n/MAZE_SIZE);
+			mazeInRobot.updateWall(cur, field.getWall(cur));
+			mazeInRobot.updateStepMap(goal, onlyUseFoundWall);
+
+			Maze fullMaze(mazeInRobot);
+			fullMaze.updateStepMap(goal, onlyUseFoundWall);
+			for (int y=0;y<MAZE_SIZE;y++) {
+				for (int x=0;x<MAZE_SIZE;x++) {
+					if (mazeInRobot.getStepMap(x,y) != fullMaze.getStepMap(x,y)) nMismatch++;
+				}
+			}
+		}
+	}
+	printf("stepmap mismatch %d\n", nMismatch);
+}
+
+//MAZE_STEPMAP_METHODを変えてビルドしたものを実行して比べる
+//checksumが同じなら同じ歩数マップができている
+void test_StepMapBenchmark(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	const int nLoop = 100000;
+	const IndexVec dist[2] = {IndexVec(7,7), IndexVec(0,0)};
+	uint32_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i=0;i<nLoop;i++) {
+		//目標座標を毎回変えて全体を計算しなおさせる
+		field.clearStepMapCache();
+		field.updateStepMap(dist[i%2], i%4 < 2);
+		checksum += field.getStepMap(i%MAZE_SIZE, (i/MAZE_SIZE)%MAZE_SIZE);
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double usec = std::chrono::duration<double, std::micro>(end - start).count();
+	printf("method %d : %.3f us/map checksum %u\n", MAZE_STEPMAP_METHOD, usec/nLoop, checksum);
+}
+
+void test_StepMapCache(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	//壁が変わらない間は、ゴールとスタートを交互に目標にしてもキャッシュから取り出すだけ
+	const IndexList goalList = MAZE_GOAL_LIST;
+	const int nLoop = 100000;
+	uint32_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i=0;i<nLoop;i++) {
+		if (i%2) field.updateStepMap(goalList);
+		else field.updateStepMap(IndexVec(0,0));
+		checksum += field.getStepMap(i%MAZE_SIZE, (i/MAZE_SIZE)%MAZE_SIZE);
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double usec = std::chrono::duration<double, std::micro>(end - start).count();
+	printf("cache size %d : %.3f us/map checksum %u\n", STEPMAP_CACHE_SIZE, usec/nLoop, checksum);
+
+	//壁が変わったら計算しなおす
+	field.updateStepMap(goalList);
+	const Maze::Step before = field.getStepMap(0,0);
+	field.updateWall(IndexVec(0,0), Direction(0x0f));
+	field.updateStepMap(IndexVec(0,0));
+	field.updateStepMap(goalList);
+	printf("step at start %d -> %d after closing the start\n", before, field.getStepMap(0,0));
+}
+
 void test_ShortestPath(const char *filename)
 {
 	Maze field;
 	field.loadFromFile(filename);
-	//field.loadFromArray(mazeData_66test);
+	//field.loadFromImage(mazeData_66test);
 
 	ShortestPath path(field);
 	for (int i=0;i<100000;i++) {
@@ -52,7 +156,7 @@ void test_KShortestPath(const char *filename)
 {
 	Maze field;
 	field.loadFromFile(filename);
-	//field.loadFromArray(mazeData_66test);
+	//field.loadFromImage(mazeData_66test);
 
 	ShortestPath path(field);
 	path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, 5, false);
@@ -74,7 +178,7 @@ void test_ShortestPathInTime(const char *filename)
 {
 	Maze field;
 	field.loadFromFile(filename);
-	//field.loadFromArray(mazeData_maze);
+	//field.loadFromImage(mazeData_maze);
 
 	ShortestPath path(field,true);
 	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false, true);
@@ -89,12 +193,331 @@ void test_ShortestPathInTime(const char *filename)
 	field.printWall(route);
 }
 
+void test_ShortestPathByStateGraph(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	//k最短経路から選んだ経路と比べる
+	ShortestPath path(field,true);
+	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false, true);
+	printf("k shortest  cost %f\n", path.getShortestTimePathCost());
+
+	path.calcShortestTimePathByStateGraph(IndexVec(0,0), MAZE_GOAL_LIST, false, true);
+	printf("state graph cost %f\n", path.getShortestTimePathCost());
+
+	auto &p = path.getShortestTimePath();
+	printf("length %lu\n", p.size());
+	OperationList opList = path.getShortestTimePathOperation();
+	opList.print();
+	bool route[MAZE_SIZE][MAZE_SIZE] = {false};
+	for (auto &index : p) {
+		route[index.y][index.x] = true;
+	}
+	field.printWall(route);
+}
+
+//最高速度を変えた走行性能ごとに、k最短経路の中で一番速い経路を選ぶ
+//RobotProfileSetで各候補の全速度でのコストをまとめて計算し、状態グラフで直接計算した経路と比べる
+void test_RobotProfile(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	RobotProfileSet profiles;
+	const double velocity[] = { 1.0, 1.5, 2.0, 3.0, 4.0 };
+	for (double v : velocity) {
+		profiles.add(RobotProfile(TURN90_TIME, TURN45_TIME, ACCELERATION, v));
+	}
+
+	ShortestPath path(field,true);
+	path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false);
+	const auto &candidates = path.getKShortestDistancePath();
+
+	std::vector<float> bestCost(profiles.size(), FLT_MAX);
+	std::vector<size_t> bestIndex(profiles.size(), 0);
+	std::vector<float> cost(profiles.size());
+	for (size_t i=0;i<candidates.size();i++) {
+		OperationList opList(candidates[i], true);
+		profiles.eval(opList, cost.data());
+		for (size_t j=0;j<profiles.size();j++) {
+			if (cost[j] < bestCost[j]) {
+				bestCost[j] = cost[j];
+				bestIndex[j] = i;
+			}
+		}
+	}
+
+	for (size_t j=0;j<profiles.size();j++) {
+		path.calcShortestTimePathByStateGraph(IndexVec(0,0), MAZE_GOAL_LIST, false, true, profiles[j]);
+		printf("max velocity %.1f : k shortest #%lu cost %f, state graph cost %f\n", profiles[j].getMaxVelocity(),
+				bestIndex[j], bestCost[j], path.getShortestTimePathCost());
+	}
+}
+
+//ターンの速度を指定して速度を持ち越すモデルで計算する
+//ターンの速度をminVelocityにすると表のモデルと同じコストになるか、ターンを速くすると選ぶ経路が変わるかを見る
+void test_VelocityModel(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	RobotProfile tableModel;
+	RobotProfile sameAsTable;
+	sameAsTable.setTurnVelocity(Operation::TURN_RIGHT90, MIN_VELOCITY, MIN_VELOCITY);
+	sameAsTable.setTurnVelocity(Operation::TURN_RIGHT45, MIN_VELOCITY, MIN_VELOCITY);
+	RobotProfile fastTurn;
+	fastTurn.setTurnVelocity(Operation::TURN_RIGHT90, 0.7, 0.7);
+	fastTurn.setTurnVelocity(Operation::TURN_RIGHT45, 0.9, 1.1);
+
+	ShortestPath path(field,true);
+	path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false);
+	const auto &candidates = path.getKShortestDistancePath();
+
+	float maxDiff = 0.0;
+	for (size_t i=0;i<candidates.size();i++) {
+		OperationList opList(candidates[i], true);
+		const float diff = std::fabs(opList.eval(tableModel) - opList.eval(sameAsTable));
+		if (diff > maxDiff) maxDiff = diff;
+	}
+	printf("max difference from table model %e\n", maxDiff);
+
+	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false, true, tableModel);
+	const float tableCost = path.getShortestTimePathOperation().eval(fastTurn);
+	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false, true, fastTurn);
+	printf("fast turn : path chosen by table model %f, by velocity model %f\n", tableCost, path.getShortestTimePathCost());
+	OperationList opList = path.getShortestTimePathOperation();
+	opList.print();
+}
+
+void test_LargeTurn(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	RobotProfile smallTurn;
+	RobotProfile largeTurn;
+	largeTurn.setLargeTurn(true);
+
+	//変換してもたどる区画は変わらないので、直線とターンで進む区画の数は同じになる
+	ShortestPath path(field,true);
+	path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false);
+	const auto &candidates = path.getKShortestDistancePath();
+	int nFaster = 0;
+	for (size_t i=0;i<candidates.size();i++) {
+		OperationList opList(candidates[i], true);
+		const float before = opList.eval(smallTurn);
+		opList.convertToLargeTurn();
+		if (opList.eval(largeTurn) < before) nFaster++;
+	}
+	printf("%d / %d paths are faster with large turns\n", nFaster, (int)candidates.size());
+
+	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false, true, smallTurn);
+	printf("small turn %f\n", path.getShortestTimePathCost());
+	path.calcShortestTimePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false, true, largeTurn);
+	printf("large turn %f\n", path.getShortestTimePathCost());
+	OperationList opList = path.getShortestTimePathOperation();
+	opList.print();
+}
+
+void test_PathCompiler(const char *filename)
+{
+	//おかしな経路はエラーになる
+	Path gap;
+	gap.push_back(IndexVec(0,0));
+	gap.push_back(IndexVec(0,2));
+	Path uTurn;
+	uTurn.push_back(IndexVec(0,0));
+	uTurn.push_back(IndexVec(0,1));
+	uTurn.push_back(IndexVec(0,0));
+	OperationList opList;
+	printf("gap %d, u-turn %d\n", opList.loadFromPath(gap, true), opList.loadFromPath(uTurn, true));
+
+	Maze field;
+	field.loadFromFile(filename);
+	ShortestPath path(field,true);
+	path.calcKShortestDistancePath(IndexVec(0,0), MAZE_GOAL_LIST, 20, false);
+	const auto &candidates = path.getKShortestDistancePath();
+
+	//足りないbufferはPATH_BUFFER_FULL
+	Operation buffer[MAZE_SIZE*MAZE_SIZE];
+	size_t nOp = 0;
+	printf("small buffer %d\n", OperationList::compilePath(candidates[0], true, buffer, 2, nOp));
+
+	//k個の候補を全部変換する時間
+	const int nLoop = 1000;
+	auto start = std::chrono::steady_clock::now();
+	size_t total = 0;
+	for (int loop=0;loop<nLoop;loop++) {
+		for (const auto &candidate : candidates) {
+			OperationList::compilePath(candidate, true, buffer, MAZE_SIZE*MAZE_SIZE, nOp);
+			total += nOp;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double usec = std::chrono::duration<double, std::micro>(end - start).count();
+	printf("%d paths, %zu operations, %f usec/path\n", (int)candidates.size(), total/nLoop, usec/nLoop/candidates.size());
+}
+
+void test_MultiSourceStepMap(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	//全てのゴールから同時に広げた歩数マップは、ゴールごとの歩数マップの最小値と同じになる
+	IndexList goalList = MAZE_GOAL_LIST;
+	Maze::Step minStep[MAZE_SIZE][MAZE_SIZE];
+	for (int y=0;y<MAZE_SIZE;y++) {
+		for (int x=0;x<MAZE_SIZE;x++) {
+			minStep[y][x] = Maze::STEP_MAX;
+		}
+	}
+	for (const IndexVec &goal : goalList) {
+		field.updateStepMap(goal);
+		for (int y=0;y<MAZE_SIZE;y++) {
+			for (int x=0;x<MAZE_SIZE;x++) {
+				if (field.getStepMap(x,y) < minStep[y][x]) minStep[y][x] = field.getStepMap(x,y);
+			}
+		}
+	}
+	field.updateStepMap(goalList);
+	int nDiff = 0;
+	for (int y=0;y<MAZE_SIZE;y++) {
+		for (int x=0;x<MAZE_SIZE;x++) {
+			if (field.getStepMap(x,y) != minStep[y][x]) nDiff++;
+		}
+	}
+	field.printStepMap();
+	printf("%d cells differ from the minimum of single goal maps\n", nDiff);
+
+	ShortestPath path(field);
+	path.calcShortestDistancePath(IndexVec(0,0), goalList, false);
+	printf("distance to the nearest goal %d, path length %d\n", field.getStepMap(0,0), (int)path.getShortestDistancePath().size()-1);
+}
+
+void test_DistanceOracle(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	//全ての区画の組について、歩数マップと同じ歩数になっているか確かめる
+	DistanceOracle oracle;
+	oracle.sync(field);
+	int nError = 0;
+	for (int i=0;i<MAZE_SIZE*MAZE_SIZE;i++) {
+		const IndexVec to(i%MAZE_SIZE, i/MAZE_SIZE);
+		field.updateStepMap(to);
+		for (int j=0;j<MAZE_SIZE*MAZE_SIZE;j++) {
+			const IndexVec from(j%MAZE_SIZE, j/MAZE_SIZE);
+			if (oracle.getDistance(from, to) != field.getStepMap(from.x, from.y)) nError++;
+		}
+	}
+	printf("error %d rows %u\n", nError, oracle.getRowCalcCount());
+
+	//計算済みの行は表を引くだけ
+	const int nLoop = 1000000;
+	uint32_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i=0;i<nLoop;i++) {
+		checksum += oracle.getDistance(IndexVec(i%MAZE_SIZE, (i/MAZE_SIZE)%MAZE_SIZE), IndexVec((i*7)%MAZE_SIZE, (i*3)%MAZE_SIZE));
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double nsec = std::chrono::duration<double, std::nano>(end - start).count();
+	printf("%.2f ns/query checksum %u\n", nsec/nLoop, checksum);
+
+	//壁を増やすと、その壁を通っていた行だけ計算しなおす
+	const uint32_t before = oracle.getRowCalcCount();
+	field.updateWall(IndexVec(0,1), Direction(0x0f));
+	oracle.sync(field);
+	for (int i=0;i<MAZE_SIZE*MAZE_SIZE;i++) oracle.getRow(IndexVec(i%MAZE_SIZE, i/MAZE_SIZE));
+	printf("%u rows recalculated after closing (0,1)\n", oracle.getRowCalcCount() - before);
+}
+
+void test_SearchTour(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+	DistanceOracle oracle;
+	oracle.sync(field);
+
+	//ばらばらの区画を回る順番を、改善なし(一番近い区画を順にたどるだけ)と改善ありで比べる
+	IndexList targets;
+	for (int i=0;i<MAZE_SIZE*MAZE_SIZE;i+=11) targets.push_back(IndexVec((i*7)%MAZE_SIZE, i/MAZE_SIZE));
+
+	const uint32_t budgets[] = { 0, 256, AGENT_SEARCH_TOUR_BUDGET };
+	for (auto budget : budgets) {
+		SearchTour tour;
+		const int nLoop = 1000;
+		auto start = std::chrono::steady_clock::now();
+		for (int i=0;i<nLoop;i++) {
+			tour.clear();
+			tour.plan(oracle, IndexVec(0,0), targets, budget);
+		}
+		auto end = std::chrono::steady_clock::now();
+		const double usec = std::chrono::duration<double, std::micro>(end - start).count();
+		printf("budget %5u : %lu cells length %u eval %u %.1f us/plan\n", budget, tour.getTour().size(), tour.getLength(), tour.getEvalCount(), usec/nLoop);
+	}
+}
+
+void test_SearchByTime(const char *filename)
+{
+	Maze field;
+	field.loadFromFile(filename);
+
+	//西半分(ゴールの列まで)だけ探索済みの迷路で、今わかっている壁だけで走れる走行時間と、探索する座標の数を見る
+	//marginを大きくしたときは、SEARCH_TIME_THRESHOLD以上速くなりうる壁を全て数える
+	Maze half;
+	for (int y=0;y<MAZE_SIZE;y++) {
+		for (int x=0;x<=MAZE_SIZE/2;x++) half.updateWall(IndexVec(x,y), field.getWall(x,y));
+	}
+	const Maze *mazes[] = { &half, &field };
+	const float margins[] = { SEARCH_TIME_MARGIN, FLT_MAX };
+	for (auto maze : mazes) {
+		ShortestPath path(*const_cast<Maze *>(maze));
+		for (auto margin : margins) {
+			const float knownCost = path.calcNeedToSearchWallIndexByTime(IndexVec(0,0), MAZE_GOAL_LIST, SEARCH_TIME_THRESHOLD, margin, true);
+			if (knownCost == FLT_MAX) printf("known ----- s ");
+			else printf("known %.3f s ", knownCost);
+			if (margin == FLT_MAX) printf("margin ----- s ");
+			else printf("margin %.3f s ", margin);
+			printf(": %lu cells to search\n", path.getNeedToSearchIndex().size());
+		}
+	}
+}
+
+//探索と最終的な経路の計算にかかった時間を、場所ごと、Agentの状態ごとに出す
+//-DMAZESOLVER_PROFILE=1でビルドしないと何も記録されない
+void test_Profiler(const char *filename)
+{
+	Maze field;
+	Maze mazeInRobot;
+	field.loadFromFile(filename);
+
+	Agent agent(mazeInRobot);
+	Profiler::clear();
+
+	IndexVec cur(0,0);
+	while(1) {
+		agent.update(cur, field.getWall(cur));
+		if (agent.getState() == Agent::FINISHED) break;
+
+		Direction dir = agent.getNextDirection();
+		for (int i=0;i<4;i++) {
+			if (dir[i]) cur += IndexVec::vecDir[i];
+		}
+	}
+	agent.caclRunSequence(true);
+
+	Profiler::print();
+	printf("worst Agent::update : %.3f us\n", Profiler::toSecond(Profiler::getStat(PROFILE_AGENT_UPDATE).max)*1e6);
+}
+
 void test_Agent(const char *filename)
 {
 	Maze field;
 	Maze mazeInRobot;
 	field.loadFromFile(filename);
-	//field.loadFromArray(mazeData_66test);
+	//field.loadFromImage(mazeData_66test);
 
 	Agent agent(mazeInRobot);
 
@@ -122,6 +545,157 @@ void test_Agent(const char *filename)
 	mazeInRobot.printWall(route);
 }
 
+//16x16の迷路を2x2に並べて32x32(ハーフサイズ)の迷路をつくって探索する
+//16x16のMazeと同じプロセスで扱えることの確認
+void test_HalfSize(const char *filename)
+{
+	Maze classic;
+	classic.loadFromFile(filename);
+
+	MazeT<32> field;
+	for (int y=0;y<32;y++) {
+		for (int x=0;x<32;x++) {
+			uint8_t w = classic.getWall(x%MAZE_SIZE, y%MAZE_SIZE).byte & 0x0f;
+			//並べた迷路のつなぎ目の壁は取り除く
+			if (y == MAZE_SIZE-1) w &= ~NORTH;
+			if (y == MAZE_SIZE) w &= ~SOUTH;
+			if (x == MAZE_SIZE-1) w &= ~EAST;
+			if (x == MAZE_SIZE) w &= ~WEST;
+			field.updateWall(IndexVec(x,y), Direction(w));
+		}
+	}
+
+	MazeT<32> mazeInRobot;
+	AgentT<32> agent(mazeInRobot);
+	IndexVec cur(0,0);
+	int nStep = 0;
+	while(1) {
+		agent.update(cur, field.getWall(cur));
+		if (agent.getState() == AgentT<32>::FINISHED) break;
+
+		Direction dir = agent.getNextDirection();
+		for (int i=0;i<4;i++) {
+			if (dir[i]) cur += IndexVec::vecDir[i];
+		}
+		nStep++;
+	}
+
+	agent.caclRunSequence(true);
+	printf("half size : search %d steps, run length %lu, cost %f\n", nStep, agent.getShortestPath().size(), agent.getRunSequence().eval());
+}
+
+
+//探索から最終的な経路の計算までを同じAgentで2回行い、それぞれでヒープを確保した回数を表示する
+//2回目(確保した作業領域を使いまわす)は0回になる
+void test_Allocation(const char *filename)
+{
+	Maze field;
+	Maze mazeInRobot;
+	field.loadFromFile(filename);
+
+	Agent agent(mazeInRobot);
+	for (int n=0;n<2;n++) {
+		mazeInRobot.clear();
+		agent.reset();
+		const size_t nAllocationStart = nAllocation;
+
+		IndexVec cur(0,0);
+		while(1) {
+			agent.update(cur, field.getWall(cur));
+			if (agent.getState() == Agent::FINISHED) break;
+
+			Direction dir = agent.getNextDirection();
+			for (int i=0;i<4;i++) {
+				if (dir[i]) cur += IndexVec::vecDir[i];
+			}
+		}
+		agent.caclRunSequence(true);
+
+		printf("cycle %d : %lu allocations\n", n, nAllocation - nAllocationStart);
+	}
+}
+
+//種類ごとにシードを変えて迷路を生成し、
+//スタートの東が壁、ゴールに到達できる、同じシードなら同じ迷路、PERFECTは全区画に到達できてループがない、を確認する
+//最後に各種類の迷路を1つずつ表示して、maze_generated_*.datに保存する
+void test_MazeGenerator()
+{
+	const int nSeed = 1000;
+	for (int t=MazeGenerator::PERFECT;t<=MazeGenerator::ADVERSARIAL;t++) {
+		const MazeGenerator::Type type = (MazeGenerator::Type)t;
+		int nError = 0;
+		for (int seed=0;seed<nSeed;seed++) {
+			Maze maze, maze2;
+			MazeGenerator(seed).generate(maze, type);
+			MazeGenerator(seed).generate(maze2, type);
+
+			bool ok = true;
+			ok &= maze.getWall(0,0)[1] && !maze.getWall(0,0)[0];
+			maze.updateStepMap(IndexVec(MAZE_SIZE/2, MAZE_SIZE/2));
+			ok &= maze.getStepMap(IndexVec(0,0)) != Maze::STEP_MAX;
+
+			int nOpen = 0;
+			for (int y=0;y<MAZE_SIZE;y++) {
+				for (int x=0;x<MAZE_SIZE;x++) {
+					ok &= maze.getWall(x,y) == maze2.getWall(x,y);
+					if (!maze.getWall(x,y)[0]) nOpen++;
+					if (!maze.getWall(x,y)[1]) nOpen++;
+					if (type == MazeGenerator::PERFECT) ok &= maze.getStepMap(IndexVec(x,y)) != Maze::STEP_MAX || maze.getWall(x,y).nWall() == 4;
+				}
+			}
+			//ループがない迷路の通路の数は区画数-1 ゴールの中の4つの通路のうち1つ分はループ
+			if (type == MazeGenerator::PERFECT) ok &= nOpen == MAZE_SIZE*MAZE_SIZE;
+
+			if (!ok) nError++;
+		}
+		printf("%s : %d / %d error\n", MazeGenerator::typeName(type), nError, nSeed);
+	}
+
+	for (int t=MazeGenerator::PERFECT;t<=MazeGenerator::ADVERSARIAL;t++) {
+		const MazeGenerator::Type type = (MazeGenerator::Type)t;
+		Maze maze;
+		MazeGenerator(1).generate(maze, type);
+		printf("%s\n", MazeGenerator::typeName(type));
+		maze.printWall();
+
+		char filename[64];
+		snprintf(filename, sizeof(filename), "maze_generated_%s.dat", MazeGenerator::typeName(type));
+		maze.saveToFile(filename);
+	}
+}
+
+//生成した迷路を迷路コーパスに保存して、開きなおした迷路が元と同じか確認する
+void test_MazeCorpus(const char *filename)
+{
+	const int nMaze = 1000;
+	MazeCorpusWriter writer;
+	writer.open(filename, Agent::defaultGoalList());
+	for (int seed=0;seed<nMaze;seed++) {
+		Maze maze;
+		MazeGenerator(seed).generate(maze, MazeGenerator::LOOPY);
+		writer.add(maze);
+	}
+	writer.close();
+
+	MazeCorpus corpus;
+	if (!corpus.open(filename)) return;
+	printf("%lu mazes, %lu goals\n", corpus.size(), corpus.getGoalList().size());
+
+	int nError = 0;
+	for (size_t i=0;i<corpus.size();i++) {
+		Maze maze, copied;
+		MazeGenerator(i).generate(maze, MazeGenerator::LOOPY);
+		corpus[i].copyTo(copied);
+		for (int y=0;y<MAZE_SIZE;y++) {
+			for (int x=0;x<MAZE_SIZE;x++) {
+				if (corpus[i].getWall(x,y) != maze.getWall(x,y) || copied.getWall(x,y) != maze.getWall(x,y)) {
+					nError++;
+				}
+			}
+		}
+	}
+	printf("%d error\n", nError);
+}
 
 int main(int argc, char **argv)
 {
@@ -133,10 +707,27 @@ int main(int argc, char **argv)
 
 	//test_Maze(argv[1]);
 	//test_Size();
+	//test_StepMapRepair(argv[1]);
+	//test_StepMapBenchmark(argv[1]);
+	//test_StepMapCache(argv[1]);
 	test_Agent(argv[1]);
 	//test_ShortestPath(argv[1]);
 	//test_KShortestPath(argv[1]);
 	//test_ShortestPathInTime(argv[1]);
+	//test_ShortestPathByStateGraph(argv[1]);
+	//test_HalfSize(argv[1]);
+	//test_Allocation(argv[1]);
+	//test_MazeGenerator();
+	//test_MazeCorpus("mazes.mzc");
+	//test_RobotProfile(argv[1]);
+	//test_VelocityModel(argv[1]);
+	//test_LargeTurn(argv[1]);
+	//test_PathCompiler(argv[1]);
+	//test_MultiSourceStepMap(argv[1]);
+	//test_DistanceOracle(argv[1]);
+	//test_SearchTour(argv[1]);
+	//test_SearchByTime(argv[1]);
+	//test_Profiler(argv[1]);
 
 	printf("finish\n");
 
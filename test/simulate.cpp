@@ -0,0 +1,381 @@
+/**************************************************************
+ * simulate
+ *	迷路ファイルをまとめて読み込み、それぞれの迷路で
+ *	Agentによる探索(FINISHEDになるまで)と最終的な走行ルートの計算を行い、結果をCSVかJSONで出力する
+ *	迷路ごとの計算は複数のスレッドで並列に行うが、出力は引数で渡した順に並べる
+ *	アルゴリズムを変更したときに結果が変わっていないか、速くなったかを確認するのに使う
+ *
+ *	使い方
+ *	simulate [-j スレッド数] [-f csv|json] [-n] [-g 種類[:個数[:シード]]]... [-w ディレクトリ] [-c コーパス] 迷路ファイルかディレクトリ...
+ *	-j:並列に計算するスレッド数(デフォルトはCPUのコア数)
+ *	-f:出力形式(デフォルトはcsv)
+ *	-n:斜め走行なしで最終的な走行ルートを計算する
+ *	-g:MazeGeneratorで生成した迷路も使う 種類はperfect,loopy,diagonal,adversarial
+ *	   シード(デフォルトは1)から個数(デフォルトは1)分の連続したシードで生成する 迷路の名前はgen:種類:シード
+ *	-w:生成した迷路をディレクトリに種類_シード.datで保存する
+ *	-c:シミュレーションはせずに、全ての迷路を迷路コーパス(MazeCorpus.h)にまとめて保存する
+ *	迷路コーパス(.mzc)を渡した場合は、その中の迷路を全て使う 迷路の名前はファイル名#番号
+ *	ディレクトリを渡した場合は、その中の.datと.mzcファイルを名前順に全て読み込む
+ **************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+
+#include "MazeSolver_conf.h"
+#include "Maze.h"
+#include "Agent.h"
+#include "MazeGenerator.h"
+#include "MazeCorpus.h"
+
+//探索がこれ以上updateを呼んでも終わらない場合は打ち切る
+const int SIMULATE_MAX_UPDATE = 10000;
+
+/**************************************************************
+ * SimulateResult
+ *	1つの迷路のシミュレーション結果
+ **************************************************************/
+struct SimulateResult {
+	typedef enum {
+		FINISHED, 		//最終的な走行ルートまで計算できた
+		TIMEOUT, 		//探索がSIMULATE_MAX_UPDATE回のupdateで終わらなかった
+		NO_ROUTE, 		//探索は終わったが、ゴールへの経路がなかった
+		LOAD_ERROR 		//迷路ファイルが読み込めなかった
+	} Status;
+
+	Status status;
+	int nMove; 			//探索中に進んだ区画数
+	int nUpdate; 		//Agent::updateを呼んだ回数
+	double searchTime; 	//探索にかかった時間[ms](Agent::updateの合計)
+	double planTime; 	//caclRunSequenceにかかった時間[ms]
+	size_t pathLength; 	//最終的な走行ルートの区画数
+	size_t nOperation; 	//最終的な走行ルートの動作の数
+	float cost; 		//最終的な走行ルートのコスト(OperationList::eval)
+
+	SimulateResult() : status(LOAD_ERROR), nMove(0), nUpdate(0), searchTime(0), planTime(0), pathLength(0), nOperation(0), cost(0) {}
+
+	const char *statusString() const
+	{
+		switch (status) {
+		case FINISHED: return "finished";
+		case TIMEOUT: return "timeout";
+		case NO_ROUTE: return "no_route";
+		default: return "load_error";
+		}
+	}
+};
+
+
+/**************************************************************
+ * MazeSource
+ *	シミュレーションする迷路
+ *	迷路ファイル、MazeGeneratorの種類とシード、迷路コーパスの中の番号のどれか
+ *	迷路コーパスは開いたままにしておき、迷路ごとにメモリを確保しない
+ **************************************************************/
+struct MazeSource {
+	typedef enum {
+		DAT_FILE,
+		GENERATED,
+		CORPUS
+	} Kind;
+
+	Kind kind;
+	std::string filename; 			//DAT_FILE
+	MazeGenerator::Type type; 		//GENERATED
+	uint64_t seed; 					//GENERATED
+	const MazeCorpus *corpus; 		//CORPUS
+	const std::string *corpusName; 	//CORPUS
+	size_t index; 					//CORPUS
+
+	MazeSource(const std::string &_filename) : kind(DAT_FILE), filename(_filename), type(MazeGenerator::PERFECT), seed(0), corpus(NULL), corpusName(NULL), index(0) {}
+	MazeSource(MazeGenerator::Type _type, uint64_t _seed) : kind(GENERATED), type(_type), seed(_seed), corpus(NULL), corpusName(NULL), index(0) {}
+	MazeSource(const MazeCorpus &_corpus, const std::string &_corpusName, size_t _index)
+		: kind(CORPUS), type(MazeGenerator::PERFECT), seed(0), corpus(&_corpus), corpusName(&_corpusName), index(_index) {}
+
+	std::string name() const
+	{
+		switch (kind) {
+		case DAT_FILE: return filename;
+		case GENERATED: return std::string("gen:") + MazeGenerator::typeName(type) + ":" + std::to_string(seed);
+		default: return *corpusName + "#" + std::to_string(index);
+		}
+	}
+
+	//迷路を読み込むか生成する
+	bool load(Maze &field) const
+	{
+		switch (kind) {
+		case DAT_FILE:
+			return field.loadFromFile(filename.c_str());
+		case GENERATED:
+			MazeGenerator(seed).generate(field, type);
+			return true;
+		default:
+			(*corpus)[index].copyTo(field);
+			return true;
+		}
+	}
+
+	Agent::IndexList goalList() const
+	{
+		if (kind == CORPUS && !corpus->getGoalList().empty()) return corpus->getGoalList();
+		return Agent::defaultGoalList();
+	}
+};
+
+//開いた迷路コーパス MazeSourceが指しているので最後まで閉じない
+static std::vector<std::unique_ptr<MazeCorpus> > corpora;
+static std::vector<std::unique_ptr<std::string> > corpusNames;
+
+
+//1つの迷路で探索と最終的な走行ルートの計算を行う
+static SimulateResult simulate(const MazeSource &source, bool useDiagonalPath)
+{
+	typedef std::chrono::steady_clock Clock;
+	SimulateResult result;
+
+	Maze field;
+	if (!source.load(field)) return result;
+
+	Maze mazeInRobot;
+	Agent agent(mazeInRobot, source.goalList());
+
+	IndexVec cur(0,0);
+	result.status = SimulateResult::TIMEOUT;
+	const Clock::time_point searchStart = Clock::now();
+	while (result.nUpdate < SIMULATE_MAX_UPDATE) {
+		agent.update(cur, field.getWall(cur));
+		result.nUpdate++;
+		if (agent.getState() == Agent::FINISHED) {
+			result.status = SimulateResult::FINISHED;
+			break;
+		}
+
+		Direction dir = agent.getNextDirection();
+		for (int i=0;i<4;i++) {
+			if (dir[i]) {
+				cur += IndexVec::vecDir[i];
+				result.nMove++;
+			}
+		}
+	}
+	result.searchTime = std::chrono::duration<double, std::milli>(Clock::now() - searchStart).count();
+	if (result.status != SimulateResult::FINISHED) return result;
+
+	const Clock::time_point planStart = Clock::now();
+	agent.caclRunSequence(useDiagonalPath);
+	result.planTime = std::chrono::duration<double, std::milli>(Clock::now() - planStart).count();
+
+	result.pathLength = agent.getShortestPath().size();
+	result.nOperation = agent.getRunSequence().size();
+	result.cost = agent.getRunSequence().eval();
+	if (result.pathLength == 0) result.status = SimulateResult::NO_ROUTE;
+
+	return result;
+}
+
+static bool hasExtension(const char *filename, const char *extension)
+{
+	const size_t len = strlen(filename);
+	const size_t extLen = strlen(extension);
+	return len > extLen && strcmp(filename + len - extLen, extension) == 0;
+}
+
+//迷路コーパスを開いて、中の迷路を全てリストに入れる
+//開けなかった場合はLOAD_ERRORになるように迷路ファイルとして入れる
+static void addMazeCorpus(const char *filename, std::vector<MazeSource> &sources)
+{
+	std::unique_ptr<MazeCorpus> corpus(new MazeCorpus());
+	if (!corpus->open(filename)) {
+		sources.push_back(MazeSource(filename));
+		return;
+	}
+
+	corpusNames.push_back(std::unique_ptr<std::string>(new std::string(filename)));
+	for (size_t i=0;i<corpus->size();i++) {
+		sources.push_back(MazeSource(*corpus, *corpusNames.back(), i));
+	}
+	corpora.push_back(std::move(corpus));
+}
+
+//引数のファイル、ディレクトリから迷路ファイルのリストをつくる
+static void addMazeFiles(const char *path, std::vector<MazeSource> &sources)
+{
+	struct stat st;
+	if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+		if (hasExtension(path, ".mzc")) addMazeCorpus(path, sources);
+		else sources.push_back(MazeSource(path));
+		return;
+	}
+
+	DIR *dir = opendir(path);
+	if (dir == NULL) return;
+
+	std::vector<std::string> found;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (hasExtension(entry->d_name, ".dat") || hasExtension(entry->d_name, ".mzc")) {
+			found.push_back(std::string(path) + "/" + entry->d_name);
+		}
+	}
+	closedir(dir);
+
+	std::sort(found.begin(), found.end());
+	for (const std::string &filename : found) {
+		if (hasExtension(filename.c_str(), ".mzc")) addMazeCorpus(filename.c_str(), sources);
+		else sources.push_back(MazeSource(filename));
+	}
+}
+
+//"種類[:個数[:シード]]"から生成する迷路のリストをつくる
+//種類の名前が違う場合はfalseを返す
+static bool addGeneratedMazes(const char *arg, std::vector<MazeSource> &sources)
+{
+	char name[32] = {};
+	unsigned long count = 1;
+	unsigned long long seed = 1;
+	if (sscanf(arg, "%31[^:]:%lu:%llu", name, &count, &seed) < 1) return false;
+
+	MazeGenerator::Type type;
+	if (!MazeGenerator::typeFromName(name, type)) return false;
+
+	for (unsigned long i=0;i<count;i++) {
+		sources.push_back(MazeSource(type, seed + i));
+	}
+	return true;
+}
+
+//生成した迷路をdirectoryに保存する
+static void saveGeneratedMazes(const char *directory, const std::vector<MazeSource> &sources)
+{
+	for (const MazeSource &source : sources) {
+		if (source.kind != MazeSource::GENERATED) continue;
+
+		Maze field;
+		source.load(field);
+		const std::string filename = std::string(directory) + "/" + MazeGenerator::typeName(source.type) + "_" + std::to_string(source.seed) + ".dat";
+		if (!field.saveToFile(filename.c_str())) {
+			fprintf(stderr, "cannot write %s\n", filename.c_str());
+		}
+	}
+}
+
+//全ての迷路を迷路コーパスにまとめて保存する
+//読めなかった迷路は飛ばす
+static bool saveMazeCorpus(const char *filename, const std::vector<MazeSource> &sources)
+{
+	MazeCorpusWriter writer;
+	if (!writer.open(filename, Agent::defaultGoalList())) return false;
+
+	Maze field;
+	for (const MazeSource &source : sources) {
+		if (source.load(field)) writer.add(field);
+	}
+	const size_t nMaze = writer.size();
+	if (!writer.close()) {
+		fprintf(stderr, "cannot write %s\n", filename);
+		return false;
+	}
+	fprintf(stderr, "%lu mazes saved to %s\n", (unsigned long)nMaze, filename);
+	return nMaze == sources.size();
+}
+
+static void printCSV(const std::vector<MazeSource> &sources, const std::vector<SimulateResult> &results)
+{
+	printf("maze,status,moves,updates,search_ms,plan_ms,path_length,operations,cost\n");
+	for (size_t i=0;i<results.size();i++) {
+		const SimulateResult &r = results[i];
+		printf("%s,%s,%d,%d,%.3f,%.3f,%lu,%lu,%f\n", sources[i].name().c_str(), r.statusString(),
+				r.nMove, r.nUpdate, r.searchTime, r.planTime, r.pathLength, r.nOperation, r.cost);
+	}
+}
+
+static void printJSON(const std::vector<MazeSource> &sources, const std::vector<SimulateResult> &results)
+{
+	printf("[\n");
+	for (size_t i=0;i<results.size();i++) {
+		const SimulateResult &r = results[i];
+		printf("  {\"maze\": \"%s\", \"status\": \"%s\", \"moves\": %d, \"updates\": %d, "
+				"\"search_ms\": %.3f, \"plan_ms\": %.3f, \"path_length\": %lu, \"operations\": %lu, \"cost\": %f}%s\n",
+				sources[i].name().c_str(), r.statusString(), r.nMove, r.nUpdate, r.searchTime, r.planTime,
+				r.pathLength, r.nOperation, r.cost, (i+1 < results.size()) ? "," : "");
+	}
+	printf("]\n");
+}
+
+int main(int argc, char **argv)
+{
+	int nThread = std::thread::hardware_concurrency();
+	bool useJSON = false;
+	bool useDiagonalPath = true;
+	const char *saveDirectory = NULL;
+	const char *corpusFilename = NULL;
+	std::vector<MazeSource> sources;
+
+	for (int i=1;i<argc;i++) {
+		if (strcmp(argv[i], "-j") == 0 && i+1 < argc) {
+			nThread = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+			useJSON = (strcmp(argv[++i], "json") == 0);
+		}
+		else if (strcmp(argv[i], "-n") == 0) {
+			useDiagonalPath = false;
+		}
+		else if (strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+			if (!addGeneratedMazes(argv[++i], sources)) {
+				fprintf(stderr, "unknown maze type: %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-w") == 0 && i+1 < argc) {
+			saveDirectory = argv[++i];
+		}
+		else if (strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+			corpusFilename = argv[++i];
+		}
+		else {
+			addMazeFiles(argv[i], sources);
+		}
+	}
+
+	if (sources.empty()) {
+		fprintf(stderr, "usage: %s [-j threads] [-f csv|json] [-n] [-g type[:count[:seed]]]... [-w directory] [-c corpus] maze_file_or_directory...\n", argv[0]);
+		return 1;
+	}
+	if (nThread < 1) nThread = 1;
+	if (saveDirectory != NULL) saveGeneratedMazes(saveDirectory, sources);
+	if (corpusFilename != NULL) return saveMazeCorpus(corpusFilename, sources) ? 0 : 2;
+
+	//空いたスレッドから次の迷路を取っていき、結果は迷路の順番の場所に入れる
+	std::vector<SimulateResult> results(sources.size());
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i=next++;i<sources.size();i=next++) {
+			results[i] = simulate(sources[i], useDiagonalPath);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int t=1;t<nThread;t++) threads.push_back(std::thread(work));
+	work();
+	for (std::thread &thread : threads) thread.join();
+
+	if (useJSON) printJSON(sources, results);
+	else printCSV(sources, results);
+
+	//全ての迷路で最後まで計算できたときだけ0を返す
+	for (const SimulateResult &r : results) {
+		if (r.status != SimulateResult::FINISHED) return 2;
+	}
+	return 0;
+}